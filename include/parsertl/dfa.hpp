@@ -44,7 +44,6 @@ namespace parsertl
 
     struct dfa_state
     {
-        cursor_vector _basis;
         cursor_vector _closure;
         cursor_vector _transitions;
     };
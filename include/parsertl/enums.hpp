@@ -8,7 +8,18 @@
 
 namespace parsertl
 {
-    enum rule_flags { enable_captures = 1 };
+    enum rule_flags
+    {
+        enable_captures = 1,
+        enable_default_reductions = 2,
+        enable_unit_elimination = 4,
+        enable_deremer_pennello = 8,
+        // SLR(1) lookaheads, falling back to LALR(1) on conflicts.
+        // A grammar with conflicts settled by %left, %right, %nonassoc
+        // or %prec still needs the LALR(1) lookaheads to check them, so
+        // builds no quicker than with enable_deremer_pennello.
+        enable_slr_lookaheads = 16
+    };
     enum action
     {
         error,
@@ -21,7 +32,8 @@ namespace parsertl
     {
         syntax_error,
         non_associative,
-        unknown_token
+        unknown_token,
+        storage_overflow
     };
 }
 
@@ -0,0 +1,63 @@
+// executor.hpp
+// Copyright (c) 2014-2023 Ben Hanson (http://www.benhanson.net/)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file licence_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef PARSERTL_EXECUTOR_HPP
+#define PARSERTL_EXECUTOR_HPP
+
+#include <cstddef>
+
+namespace parsertl
+{
+    // A batch of independent tasks numbered [0, count).
+    class job
+    {
+    public:
+        virtual ~job()
+        {
+        }
+
+        // Tasks running at the same time must be given different slots
+        // (see executor::slots()), which index per worker scratch space.
+        virtual void operator()(const std::size_t index_,
+            const std::size_t slot_) = 0;
+    };
+
+    // basic_generator::build() hands its per state work to an executor.
+    // parsertl itself starts no threads: derive from this class to run
+    // jobs on a thread pool of your choice. Results are always merged in
+    // state order, so the output does not depend on the executor.
+    class executor
+    {
+    public:
+        virtual ~executor()
+        {
+        }
+
+        // The number of tasks that may run at the same time.
+        virtual std::size_t slots() const = 0;
+        // Run job_ for every index in [0, count_) and return once
+        // they have all finished.
+        virtual void run(job& job_, const std::size_t count_) = 0;
+    };
+
+    class serial_executor : public executor
+    {
+    public:
+        virtual std::size_t slots() const
+        {
+            return 1;
+        }
+
+        virtual void run(job& job_, const std::size_t count_)
+        {
+            for (std::size_t index_ = 0; index_ < count_; ++index_)
+            {
+                job_(index_, 0);
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,194 @@
+// fixed_vector.hpp
+// Copyright (c) 2017-2023 Ben Hanson (http://www.benhanson.net/)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file licence_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef PARSERTL_FIXED_VECTOR_HPP
+#define PARSERTL_FIXED_VECTOR_HPP
+
+#include <cstddef>
+
+namespace parsertl
+{
+    // The subset of std::vector the parse drivers use, over storage
+    // owned by the caller. It never allocates: a push_back() or resize()
+    // past capacity() is dropped and sets overflow(), which the drivers
+    // report as an error of storage_overflow. clear() resets overflow().
+    template<typename T>
+    class fixed_vector
+    {
+    public:
+        typedef T value_type;
+        typedef T& reference;
+        typedef const T& const_reference;
+        typedef T* iterator;
+        typedef const T* const_iterator;
+        typedef std::size_t size_type;
+
+        fixed_vector() :
+            _data(0),
+            _capacity(0),
+            _size(0),
+            _overflow(false)
+        {
+        }
+
+        fixed_vector(T* data_, const std::size_t capacity_) :
+            _data(data_),
+            _capacity(capacity_),
+            _size(0),
+            _overflow(false)
+        {
+        }
+
+        template<std::size_t size_>
+        explicit fixed_vector(T (&data_)[size_]) :
+            _data(data_),
+            _capacity(size_),
+            _size(0),
+            _overflow(false)
+        {
+        }
+
+        iterator begin()
+        {
+            return _data;
+        }
+
+        const_iterator begin() const
+        {
+            return _data;
+        }
+
+        iterator end()
+        {
+            return _data + _size;
+        }
+
+        const_iterator end() const
+        {
+            return _data + _size;
+        }
+
+        bool empty() const
+        {
+            return _size == 0;
+        }
+
+        std::size_t size() const
+        {
+            return _size;
+        }
+
+        std::size_t capacity() const
+        {
+            return _capacity;
+        }
+
+        bool overflow() const
+        {
+            return _overflow;
+        }
+
+        void clear()
+        {
+            _size = 0;
+            _overflow = false;
+        }
+
+        void reserve(const std::size_t size_)
+        {
+            if (size_ > _capacity)
+                _overflow = true;
+        }
+
+        // Growing exposes the caller's elements as they are, so
+        // pre-built elements (such as per capture fixed_vectors)
+        // survive clear() followed by resize().
+        void resize(const std::size_t size_)
+        {
+            if (size_ > _capacity)
+                _overflow = true;
+            else
+                _size = size_;
+        }
+
+        void push_back(const T& value_)
+        {
+            if (_size == _capacity)
+                _overflow = true;
+            else
+                _data[_size++] = value_;
+        }
+
+        void pop_back()
+        {
+            --_size;
+        }
+
+        T& front()
+        {
+            return _data[0];
+        }
+
+        const T& front() const
+        {
+            return _data[0];
+        }
+
+        T& back()
+        {
+            return _data[_size - 1];
+        }
+
+        const T& back() const
+        {
+            return _data[_size - 1];
+        }
+
+        T& operator[](const std::size_t index_)
+        {
+            return _data[index_];
+        }
+
+        const T& operator[](const std::size_t index_) const
+        {
+            return _data[index_];
+        }
+
+        bool operator ==(const fixed_vector& rhs_) const
+        {
+            if (_size != rhs_._size)
+                return false;
+
+            for (std::size_t i_ = 0; i_ < _size; ++i_)
+            {
+                if (!(_data[i_] == rhs_._data[i_]))
+                    return false;
+            }
+
+            return true;
+        }
+
+    private:
+        T* _data;
+        std::size_t _capacity;
+        std::size_t _size;
+        bool _overflow;
+    };
+
+    // Growable containers never overflow.
+    template<typename container>
+    bool overflowed(const container&)
+    {
+        return false;
+    }
+
+    template<typename T>
+    bool overflowed(const fixed_vector<T>& vector_)
+    {
+        return vector_.overflow();
+    }
+}
+
+#endif
@@ -0,0 +1,402 @@
+// generate_cpp.hpp
+// Copyright (c) 2014-2023 Ben Hanson (http://www.benhanson.net/)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file licence_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef PARSERTL_GENERATE_CPP_HPP
+#define PARSERTL_GENERATE_CPP_HPP
+
+#include "narrow.hpp"
+#include <ostream>
+#include "state_machine.hpp"
+#include <string>
+#include <vector>
+
+namespace parsertl
+{
+    namespace details
+    {
+        template<typename entry>
+        void generate_entry(const entry& entry_, std::ostream& os_)
+        {
+            switch (entry_.action)
+            {
+            case error:
+                os_ << "parsertl::error, ";
+
+                switch (entry_.param)
+                {
+                case non_associative:
+                    os_ << "parsertl::non_associative";
+                    break;
+                case unknown_token:
+                    os_ << "parsertl::unknown_token";
+                    break;
+                default:
+                    os_ << "parsertl::syntax_error";
+                    break;
+                }
+
+                return;
+            case shift:
+                os_ << "parsertl::shift, ";
+                break;
+            case reduce:
+                os_ << "parsertl::reduce, ";
+                break;
+            case go_to:
+                os_ << "parsertl::go_to, ";
+                break;
+            case accept:
+                os_ << "parsertl::accept, ";
+                break;
+            }
+
+            os_ << static_cast<std::size_t>(entry_.param);
+        }
+
+        inline void generate_shift(const std::string& sm_name_,
+            const bool productions_, std::ostream& os_)
+        {
+            os_ << "    case parsertl::shift:\n";
+            os_ << "        results_.stack.push_back(results_.entry.param);\n";
+
+            if (productions_)
+            {
+                os_ << "        productions_.push_back(typename "
+                    "token_vector::value_type(iter_->id,\n";
+                os_ << "            iter_->first, iter_->second));\n";
+            }
+
+            os_ << "\n";
+            os_ << "        if (iter_->id != 0)\n";
+            os_ << "            ++iter_;\n\n";
+            os_ << "        results_.token_id = iter_->id;\n\n";
+            os_ << "        if (results_.token_id == "
+                "lexer_iterator::value_type::npos())\n";
+            os_ << "        {\n";
+            os_ << "            results_.entry.action = parsertl::error;\n";
+            os_ << "            results_.entry.param = "
+                "parsertl::unknown_token;\n";
+            os_ << "        }\n";
+            os_ << "        else if (!" << sm_name_ <<
+                "::default_reduction(results_.entry.param,\n";
+            os_ << "            results_.entry))\n";
+            os_ << "        {\n";
+            os_ << "            results_.entry = " << sm_name_ <<
+                "::at(results_.entry.param,\n";
+            os_ << "                results_.token_id);\n";
+            os_ << "        }\n\n";
+            os_ << "        break;\n";
+        }
+
+        inline void generate_reduce(const std::string& sm_name_,
+            const bool productions_, std::ostream& os_)
+        {
+            os_ << "    case parsertl::reduce:\n";
+            os_ << "    {\n";
+            os_ << "        const std::size_t size_ = " << sm_name_ <<
+                "::rule_size(results_.entry.param);\n";
+
+            if (productions_)
+            {
+                os_ << "        typename token_vector::value_type token_;\n";
+            }
+
+            os_ << "\n";
+            os_ << "        if (size_)\n";
+            os_ << "        {\n";
+            os_ << "            results_.stack.resize(results_.stack.size() - "
+                "size_);\n";
+
+            if (productions_)
+            {
+                os_ << "            token_.first = (productions_.end() - "
+                    "size_)->first;\n";
+                os_ << "            token_.second = "
+                    "productions_.back().second;\n";
+                os_ << "            productions_.resize(productions_.size() - "
+                    "size_);\n";
+                os_ << "        }\n";
+                os_ << "        else if (productions_.empty())\n";
+                os_ << "        {\n";
+                os_ << "            token_.first = token_.second = "
+                    "iter_->first;\n";
+                os_ << "        }\n";
+                os_ << "        else\n";
+                os_ << "        {\n";
+                os_ << "            token_.first = token_.second = "
+                    "productions_.back().second;\n";
+            }
+
+            os_ << "        }\n\n";
+            os_ << "        results_.token_id = " << sm_name_ <<
+                "::rule_lhs(results_.entry.param);\n";
+            os_ << "        results_.entry = " << sm_name_ <<
+                "::at(results_.stack.back(),\n";
+            os_ << "            results_.token_id);\n";
+
+            if (productions_)
+            {
+                os_ << "        token_.id = results_.token_id;\n";
+                os_ << "        productions_.push_back(token_);\n";
+            }
+
+            os_ << "        break;\n";
+            os_ << "    }\n";
+        }
+
+        inline void generate_go_to(const std::string& sm_name_,
+            std::ostream& os_)
+        {
+            os_ << "    case parsertl::go_to:\n";
+            os_ << "        results_.stack.push_back(results_.entry.param);\n";
+            os_ << "        results_.token_id = iter_->id;\n\n";
+            os_ << "        if (!" << sm_name_ <<
+                "::default_reduction(results_.stack.back(),\n";
+            os_ << "            results_.entry))\n";
+            os_ << "        {\n";
+            os_ << "            results_.entry = " << sm_name_ <<
+                "::at(results_.stack.back(),\n";
+            os_ << "                results_.token_id);\n";
+            os_ << "        }\n\n";
+            os_ << "        break;\n";
+        }
+
+        inline void generate_accept(const std::string& sm_name_,
+            std::ostream& os_)
+        {
+            os_ << "    case parsertl::accept:\n";
+            os_ << "    {\n";
+            os_ << "        const std::size_t size_ = " << sm_name_ <<
+                "::rule_size(results_.entry.param);\n\n";
+            os_ << "        if (size_)\n";
+            os_ << "        {\n";
+            os_ << "            results_.stack.resize(results_.stack.size() - "
+                "size_);\n";
+            os_ << "        }\n\n";
+            os_ << "        break;\n";
+            os_ << "    }\n";
+        }
+    }
+
+    // Emits a direct coded parser for sm_. Rather than looking entries up
+    // in tables, <name_>_state_machine switches on the state and then the
+    // token. It has the members of a state machine that
+    // basic_match_results needs, so the generated <name_>_lookup() and
+    // <name_>_parse() take a basic_match_results<<name_>_state_machine>
+    // and behave exactly as lookup() and parse() do.
+    template<typename rules_type, typename id_type>
+    void generate_cpp(const std::string& name_, const rules_type& rules_,
+        const basic_state_machine<id_type>& sm_, std::ostream& os_)
+    {
+        typedef typename rules_type::string_vector string_vector;
+        typedef basic_state_machine<id_type> sm_type;
+        const std::string sm_name_ = name_ + "_state_machine";
+        const std::string results_ = "parsertl::basic_match_results<" +
+            sm_name_ + '>';
+        string_vector symbols_;
+        std::vector<std::string> names_;
+
+        rules_.symbols(symbols_);
+        names_.reserve(symbols_.size());
+
+        for (typename string_vector::const_iterator iter_ = symbols_.begin(),
+            end_ = symbols_.end(); iter_ != end_; ++iter_)
+        {
+            std::ostringstream ss_;
+
+            narrow(iter_->c_str(), ss_);
+            names_.push_back(ss_.str());
+        }
+
+        os_ << "// Generated by parsertl::generate_cpp()\n";
+        os_ << "#include <parsertl/match_results.hpp>\n\n";
+        os_ << "struct " << sm_name_ << "\n{\n";
+        os_ << "    typedef std::size_t id_type;\n";
+        os_ << "    typedef parsertl::base_state_machine<id_type>::entry "
+            "entry;\n\n";
+        os_ << "    static entry at(const std::size_t state_)\n";
+        os_ << "    {\n";
+        os_ << "        return at(state_, 0);\n";
+        os_ << "    }\n\n";
+        os_ << "    static entry at(const std::size_t state_, "
+            "const std::size_t token_id_)\n";
+        os_ << "    {\n";
+        os_ << "        switch (state_)\n";
+        os_ << "        {\n";
+
+        for (std::size_t state_ = 0, rows_ = sm_._table.size();
+            state_ < rows_; ++state_)
+        {
+            const typename sm_type::pair_vector& row_ = sm_._table[state_];
+
+            if (row_.empty())
+                continue;
+
+            os_ << "        case " << state_ << ":\n";
+            os_ << "            switch (token_id_)\n";
+            os_ << "            {\n";
+
+            for (typename sm_type::pair_vector::const_iterator iter_ =
+                row_.begin(), end_ = row_.end(); iter_ != end_; ++iter_)
+            {
+                os_ << "            case " <<
+                    static_cast<std::size_t>(iter_->_id) << ":";
+
+                if (iter_->_id < names_.size())
+                    os_ << " // " << names_[iter_->_id];
+
+                os_ << "\n                return entry(";
+                details::generate_entry(iter_->_entry, os_);
+                os_ << ");\n";
+            }
+
+            os_ << "            default:\n";
+            os_ << "                break;\n";
+            os_ << "            }\n\n";
+            os_ << "            break;\n";
+        }
+
+        os_ << "        default:\n";
+        os_ << "            break;\n";
+        os_ << "        }\n\n";
+        os_ << "        return entry();\n";
+        os_ << "    }\n\n";
+
+        if (sm_._default_reductions.empty())
+        {
+            os_ << "    static bool default_reduction(const std::size_t, "
+                "entry&)\n";
+            os_ << "    {\n";
+            os_ << "        return false;\n";
+            os_ << "    }\n\n";
+        }
+        else
+        {
+            os_ << "    static bool default_reduction(const std::size_t "
+                "state_, entry& entry_)\n";
+            os_ << "    {\n";
+            os_ << "        switch (state_)\n";
+            os_ << "        {\n";
+
+            for (std::size_t state_ = 0,
+                size_ = sm_._default_reductions.size();
+                state_ < size_; ++state_)
+            {
+                const std::size_t rule_ = sm_._default_reductions[state_];
+
+                if (rule_ == static_cast<id_type>(~0))
+                    continue;
+
+                os_ << "        case " << state_ << ":\n";
+                os_ << "            entry_ = entry(parsertl::reduce, " <<
+                    rule_ << ");\n";
+                os_ << "            return true;\n";
+            }
+
+            os_ << "        default:\n";
+            os_ << "            return false;\n";
+            os_ << "        }\n";
+            os_ << "    }\n\n";
+        }
+
+        os_ << "    // Number of symbols on the rhs of rule_\n";
+        os_ << "    static std::size_t rule_size(const std::size_t rule_)\n";
+        os_ << "    {\n";
+        os_ << "        switch (rule_)\n";
+        os_ << "        {\n";
+
+        for (std::size_t rule_ = 0, size_ = sm_._rules.size();
+            rule_ < size_; ++rule_)
+        {
+            if (sm_._rules[rule_]._rhs.empty())
+                continue;
+
+            os_ << "        case " << rule_ << ":\n";
+            os_ << "            return " << sm_._rules[rule_]._rhs.size() <<
+                ";\n";
+        }
+
+        os_ << "        default:\n";
+        os_ << "            return 0;\n";
+        os_ << "        }\n";
+        os_ << "    }\n\n";
+        os_ << "    static id_type rule_lhs(const std::size_t rule_)\n";
+        os_ << "    {\n";
+        os_ << "        switch (rule_)\n";
+        os_ << "        {\n";
+
+        for (std::size_t rule_ = 0, size_ = sm_._rules.size();
+            rule_ < size_; ++rule_)
+        {
+            const std::size_t lhs_ = sm_._rules[rule_]._lhs;
+
+            os_ << "        case " << rule_ << ":";
+
+            if (lhs_ < names_.size())
+                os_ << " // " << names_[lhs_];
+
+            os_ << "\n            return " << lhs_ << ";\n";
+        }
+
+        os_ << "        default:\n";
+        os_ << "            return static_cast<id_type>(~0);\n";
+        os_ << "        }\n";
+        os_ << "    }\n";
+        os_ << "};\n\n";
+
+        // lookup() without productions
+        os_ << "template<typename lexer_iterator>\n";
+        os_ << "void " << name_ << "_lookup(lexer_iterator& iter_,\n";
+        os_ << "    " << results_ << "& results_)\n";
+        os_ << "{\n";
+        os_ << "    switch (results_.entry.action)\n";
+        os_ << "    {\n";
+        details::generate_shift(sm_name_, false, os_);
+        details::generate_reduce(sm_name_, false, os_);
+        details::generate_go_to(sm_name_, os_);
+        details::generate_accept(sm_name_, os_);
+        os_ << "    default:\n";
+        os_ << "        // error\n";
+        os_ << "        break;\n";
+        os_ << "    }\n";
+        os_ << "}\n\n";
+
+        // lookup() with productions
+        os_ << "template<typename lexer_iterator, typename token_vector>\n";
+        os_ << "void " << name_ << "_lookup(lexer_iterator& iter_,\n";
+        os_ << "    " << results_ << "& results_,\n";
+        os_ << "    token_vector& productions_)\n";
+        os_ << "{\n";
+        os_ << "    switch (results_.entry.action)\n";
+        os_ << "    {\n";
+        details::generate_shift(sm_name_, true, os_);
+        details::generate_reduce(sm_name_, true, os_);
+        details::generate_go_to(sm_name_, os_);
+        details::generate_accept(sm_name_, os_);
+        os_ << "    default:\n";
+        os_ << "        // error\n";
+        os_ << "        break;\n";
+        os_ << "    }\n";
+        os_ << "}\n\n";
+
+        // parse()
+        os_ << "template<typename lexer_iterator>\n";
+        os_ << "bool " << name_ << "_parse(lexer_iterator& iter_,\n";
+        os_ << "    " << results_ << "& results_)\n";
+        os_ << "{\n";
+        os_ << "    while (results_.entry.action != parsertl::error)\n";
+        os_ << "    {\n";
+        os_ << "        const bool accept_ = results_.entry.action == "
+            "parsertl::accept;\n\n";
+        os_ << "        " << name_ << "_lookup(iter_, results_);\n\n";
+        os_ << "        if (accept_)\n";
+        os_ << "            break;\n";
+        os_ << "    }\n\n";
+        os_ << "    return results_.entry.action == parsertl::accept;\n";
+        os_ << "}\n";
+    }
+}
+
+#endif
@@ -0,0 +1,284 @@
+// generate_tables.hpp
+// Copyright (c) 2014-2023 Ben Hanson (http://www.benhanson.net/)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file licence_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef PARSERTL_GENERATE_TABLES_HPP
+#define PARSERTL_GENERATE_TABLES_HPP
+
+#include <ostream>
+#include "state_machine.hpp"
+#include <string>
+#include <vector>
+
+namespace parsertl
+{
+    namespace details
+    {
+        template<typename id_type>
+        const char* id_type_name()
+        {
+            switch (sizeof(id_type))
+            {
+            case sizeof(unsigned char):
+                return "unsigned char";
+            case sizeof(unsigned short):
+                return "unsigned short";
+            case sizeof(unsigned int):
+                return "unsigned int";
+            default:
+                return "std::size_t";
+            }
+        }
+
+        // ~0 is written as npos_, which the caller must declare.
+        template<typename vector>
+        void generate_array(const char* type_, const char* name_,
+            const vector& vec_, std::ostream& os_)
+        {
+            os_ << "    static const " << type_ << ' ' << name_ << "[] =\n";
+            os_ << "    {";
+
+            for (std::size_t idx_ = 0, size_ = vec_.size();
+                idx_ < size_; ++idx_)
+            {
+                if (idx_ % 10 == 0)
+                    os_ << "\n        ";
+                else
+                    os_ << ' ';
+
+                if (vec_[idx_] ==
+                    static_cast<typename vector::value_type>(~0))
+                    os_ << "npos_";
+                else
+                    os_ << static_cast<std::size_t>(vec_[idx_]);
+
+                if (idx_ + 1 < size_)
+                    os_ << ',';
+            }
+
+            os_ << "\n    };\n";
+        }
+
+        inline void generate_view(const char* name_, const std::size_t size_,
+            std::ostream& os_)
+        {
+            if (size_)
+                os_ << "{ " << name_ << ", " << size_ << " }";
+            else
+                os_ << "{ 0, 0 }";
+        }
+    }
+
+    // Writes sm_ as static const arrays and a function returning a
+    // basic_static_state_machine over them, so that a grammar can be
+    // compiled in rather than built at startup (compare ebnf_tables.hpp).
+    // The generated header defines <name_>_state_machine and
+    // const <name_>_state_machine& <name_>_tables().
+    template<typename id_type>
+    void generate_tables(const std::string& name_,
+        const basic_state_machine<id_type>& sm_, std::ostream& os_)
+    {
+        typedef basic_state_machine<id_type> sm_type;
+        const char* id_name_ = details::id_type_name<id_type>();
+        const std::string sm_name_ = name_ + "_state_machine";
+        std::vector<std::size_t> rhs_;
+        std::vector<std::size_t> pairs_;
+        std::vector<std::size_t> offsets_;
+        std::vector<std::size_t> ids_;
+
+        for (std::size_t idx_ = 0, size_ = sm_._rules.size();
+            idx_ < size_; ++idx_)
+        {
+            rhs_.insert(rhs_.end(), sm_._rules[idx_]._rhs.begin(),
+                sm_._rules[idx_]._rhs.end());
+        }
+
+        os_ << "// Generated by parsertl::generate_tables()\n";
+        os_ << "#include <parsertl/static_state_machine.hpp>\n\n";
+        os_ << "typedef parsertl::basic_static_state_machine<" << id_name_ <<
+            ">\n";
+        os_ << "    " << sm_name_ << ";\n\n";
+        os_ << "inline const " << sm_name_ << "& " << name_ << "_tables()\n";
+        os_ << "{\n";
+        os_ << "    typedef " << sm_name_ << " sm_type;\n";
+
+        if (!rhs_.empty())
+            details::generate_array(id_name_, "rhs_", rhs_, os_);
+
+        os_ << "    static const sm_type::rule rules_[] =\n";
+        os_ << "    {\n";
+
+        for (std::size_t idx_ = 0, offset_ = 0, size_ = sm_._rules.size();
+            idx_ < size_; ++idx_)
+        {
+            const std::size_t rhs_size_ = sm_._rules[idx_]._rhs.size();
+
+            os_ << "        { " << static_cast<std::size_t>
+                (sm_._rules[idx_]._lhs) << ", ";
+
+            if (rhs_size_)
+                os_ << "{ rhs_ + " << offset_ << ", " << rhs_size_ << " }";
+            else
+                os_ << "{ 0, 0 }";
+
+            os_ << " }";
+
+            if (idx_ + 1 < size_)
+                os_ << ',';
+
+            os_ << '\n';
+            offset_ += rhs_size_;
+        }
+
+        os_ << "    };\n";
+
+        if (!sm_._captures.empty())
+        {
+            for (std::size_t idx_ = 0, size_ = sm_._captures.size();
+                idx_ < size_; ++idx_)
+            {
+                const typename sm_type::capture_vector& vec_ =
+                    sm_._captures[idx_].second;
+
+                for (typename sm_type::capture_vector::const_iterator iter_ =
+                    vec_.begin(), end_ = vec_.end(); iter_ != end_; ++iter_)
+                {
+                    pairs_.push_back(iter_->first);
+                    pairs_.push_back(iter_->second);
+                }
+            }
+
+            if (!pairs_.empty())
+            {
+                os_ << "    static const sm_type::id_type_pair "
+                    "capture_pairs_[] =\n";
+                os_ << "    {\n";
+
+                for (std::size_t idx_ = 0, size_ = pairs_.size();
+                    idx_ < size_; idx_ += 2)
+                {
+                    os_ << "        { " << pairs_[idx_] << ", " <<
+                        pairs_[idx_ + 1] << " }";
+
+                    if (idx_ + 2 < size_)
+                        os_ << ',';
+
+                    os_ << '\n';
+                }
+
+                os_ << "    };\n";
+            }
+
+            os_ << "    static const sm_type::capture captures_[] =\n";
+            os_ << "    {\n";
+
+            for (std::size_t idx_ = 0, offset_ = 0,
+                size_ = sm_._captures.size(); idx_ < size_; ++idx_)
+            {
+                const std::size_t pairs_size_ =
+                    sm_._captures[idx_].second.size();
+
+                os_ << "        { " << sm_._captures[idx_].first << ", ";
+
+                if (pairs_size_)
+                    os_ << "{ capture_pairs_ + " << offset_ << ", " <<
+                        pairs_size_ << " }";
+                else
+                    os_ << "{ 0, 0 }";
+
+                os_ << " }";
+
+                if (idx_ + 1 < size_)
+                    os_ << ',';
+
+                os_ << '\n';
+                offset_ += pairs_size_;
+            }
+
+            os_ << "    };\n";
+        }
+
+        if (!sm_._default_reductions.empty())
+        {
+            os_ << "    static const " << id_name_ <<
+                " npos_ = static_cast<" << id_name_ << ">(~0);\n";
+            details::generate_array(id_name_, "default_reductions_",
+                sm_._default_reductions, os_);
+        }
+
+        offsets_.push_back(0);
+
+        for (std::size_t state_ = 0, rows_ = sm_._table.size();
+            state_ < rows_; ++state_)
+        {
+            const typename sm_type::pair_vector& row_ = sm_._table[state_];
+
+            for (typename sm_type::pair_vector::const_iterator iter_ =
+                row_.begin(), end_ = row_.end(); iter_ != end_; ++iter_)
+            {
+                ids_.push_back(iter_->_id);
+            }
+
+            offsets_.push_back(ids_.size());
+        }
+
+        details::generate_array("std::size_t", "offsets_", offsets_, os_);
+
+        if (!ids_.empty())
+        {
+            details::generate_array(id_name_, "ids_", ids_, os_);
+            os_ << "    static const sm_type::cell cells_[] =\n";
+            os_ << "    {";
+
+            for (std::size_t state_ = 0, idx_ = 0,
+                rows_ = sm_._table.size(); state_ < rows_; ++state_)
+            {
+                const typename sm_type::pair_vector& row_ =
+                    sm_._table[state_];
+
+                for (typename sm_type::pair_vector::const_iterator iter_ =
+                    row_.begin(), end_ = row_.end(); iter_ != end_;
+                    ++iter_, ++idx_)
+                {
+                    if (idx_ % 6 == 0)
+                        os_ << "\n        ";
+                    else
+                        os_ << ' ';
+
+                    os_ << "{ " << static_cast<std::size_t>
+                        (iter_->_entry.action) << ", " <<
+                        static_cast<std::size_t>(iter_->_entry.param) << " }";
+
+                    if (idx_ + 1 < ids_.size())
+                        os_ << ',';
+                }
+            }
+
+            os_ << "\n    };\n";
+        }
+
+        os_ << "    static const sm_type sm_ =\n";
+        os_ << "    {\n";
+        os_ << "        " << sm_._columns << ", " << sm_._terminals << ", " <<
+            sm_._rows << ",\n";
+        os_ << "        ";
+        details::generate_view("rules_", sm_._rules.size(), os_);
+        os_ << ",\n        ";
+        details::generate_view("captures_", sm_._captures.size(), os_);
+        os_ << ",\n        ";
+        details::generate_view("default_reductions_",
+            sm_._default_reductions.size(), os_);
+        os_ << ",\n        ";
+        details::generate_view("offsets_", offsets_.size(), os_);
+        os_ << ",\n        ";
+        details::generate_view("ids_", ids_.size(), os_);
+        os_ << ",\n        ";
+        details::generate_view("cells_", ids_.size(), os_);
+        os_ << "\n    };\n\n";
+        os_ << "    return sm_;\n";
+        os_ << "}\n";
+    }
+}
+
+#endif
@@ -6,10 +6,16 @@
 #ifndef PARSERTL_GENERATOR_HPP
 #define PARSERTL_GENERATOR_HPP
 
+#include <cstdio>
+#include <ctime>
 #include "dfa.hpp"
+#include "executor.hpp"
+#include <fstream>
 #include "narrow.hpp"
 #include "nt_info.hpp"
 #include "rules.hpp"
+#include "serialise.hpp"
+#include <sstream>
 #include "state_machine.hpp"
 
 namespace parsertl
@@ -60,135 +66,140 @@ namespace parsertl
 
         typedef std::deque<prod> prod_deque;
         typedef typename rules::string string;
-
-        static void build(rules& rules_, sm& sm_, std::string* warnings_ = 0)
-        {
-            dfa dfa_;
-            prod_deque new_grammar_;
-            std::size_t new_start_ = static_cast<std::size_t>(~0);
-            nt_info_vector new_nt_info_;
-            std::string warns_;
-
-            build_dfa(rules_, dfa_);
-            rewrite(rules_, dfa_, new_grammar_, new_start_, new_nt_info_);
-            build_first_sets(new_grammar_, new_nt_info_);
-            // First add EOF to follow_set of start.
-            new_nt_info_[new_start_]._follow_set[0] = 1;
-            build_follow_sets(new_grammar_, new_nt_info_);
-            sm_.clear();
-            // new_grammar_ is only used for lookup now
-            // so sort in order that std::lower_bound() can be used.
-            std::sort(new_grammar_.begin(), new_grammar_.end());
-            build_table(rules_, dfa_, new_grammar_, new_nt_info_,
-                sm_, warns_);
-
-            // Warnings are now an error
-            // unless you are explicitly fetching them
-            if (!warns_.empty())
-                if (warnings_)
-                    *warnings_ = warns_;
-                else
-                    throw runtime_error(warns_);
-
-            // If you get an assert here then your id_type
-            // is too small for the table.
-            assert(static_cast<id_type>(sm_._columns - 1) == sm_._columns - 1);
-            assert(static_cast<id_type>(sm_._rows - 1) == sm_._rows - 1);
-            copy_rules(rules_, sm_);
-            sm_._captures = rules_.captures();
-        }
-
-        static void build_dfa(rules& rules_, dfa& dfa_)
+        // One lookahead set per reduction, in dfa state then closure order.
+        typedef std::vector<bit_vector> lookahead_vector;
+
+        // Optional figures filled in by build(). Times are in seconds as
+        // read from _clock, which defaults to std::clock() (processor
+        // time). Set _clock to a wall clock to time a parallel build.
+        // Bytes are the approximate size of the intermediate structures:
+        // the DFA, rewritten grammar, FIRST, FOLLOW and lookahead sets.
+        struct build_stats
         {
-            rules_.validate();
-
-            const grammar& grammar_ = rules_.grammar();
-            const std::size_t terminals_ = rules_.tokens_info().size();
-            const std::size_t start_ = rules_.start();
-            hash_map hash_map_;
+            enum phase
+            {
+                validate_phase, dfa_phase, rewrite_phase, first_sets_phase,
+                follow_sets_phase, sort_phase, lookahead_phase, table_phase,
+                compress_phase, copy_rules_phase, phases
+            };
+
+            double (*_clock)();
+            double _seconds[phases];
+            std::size_t _bytes[phases];
+            std::size_t _states;
+            std::size_t _closure_items;
+            std::size_t _rewritten_non_terminals;
+            // Shift/reduce conflicts settled by %left, %right,
+            // %nonassoc or differing precedences.
+            std::size_t _precedence_resolutions;
+            // Entries set by build_table(), before unit elimination.
+            std::size_t _table_cells;
+
+            build_stats() :
+                _clock(0)
+            {
+                clear();
+            }
 
-            dfa_.push_back(dfa_state());
+            // Leaves _clock as it is.
+            void clear()
+            {
+                std::fill(_seconds, _seconds + phases, 0.0);
+                std::fill(_bytes, _bytes + phases, 0);
+                _states = 0;
+                _closure_items = 0;
+                _rewritten_non_terminals = 0;
+                _precedence_resolutions = 0;
+                _table_cells = 0;
+            }
 
-            // Only applies if build_dfa() has been called directly
-            // from client code (i.e. build() will have already called
-            // validate() in the normal case).
-            if (start_ == npos())
+            double now() const
             {
-                dfa_.back()._basis.push_back(cursor(0, 0));
+                return _clock ? _clock() :
+                    static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
             }
-            else
+
+            static const char* name(const phase phase_)
             {
-                const std::size_t index_ = rules_.nt_locations()[start_].
-                    _first_production;
+                static const char* names_[] =
+                {
+                    "validate", "build_dfa", "rewrite", "build_first_sets",
+                    "build_follow_sets", "sort", "build_lookaheads",
+                    "build_table", "compress", "copy_rules"
+                };
 
-                dfa_.back()._basis.push_back(cursor(index_, 0));
+                return names_[phase_];
             }
+        };
 
-            hash_map_[hash_set(dfa_.back()._basis)].push_back(0);
-
-            for (std::size_t s_ = 0; s_ < dfa_.size(); ++s_)
-            {
-                dfa_state& state_ = dfa_[s_];
-                size_t_vector symbols_;
-                typedef std::deque<cursor_vector> item_sets;
-                item_sets item_sets_;
+        static void build(rules& rules_, sm& sm_, std::string* warnings_ = 0,
+            build_stats* stats_ = 0)
+        {
+            serial_executor executor_;
 
-                state_._closure.assign(state_._basis.begin(),
-                    state_._basis.end());
-                closure(rules_, state_);
+            build_sm(rules_, sm_, executor_, warnings_, stats_);
+        }
 
-                for (typename cursor_vector::const_iterator iter_ =
-                    state_._closure.begin(), end_ = state_._closure.end();
-                    iter_ != end_; ++iter_)
-                {
-                    const production p_ = grammar_[iter_->_id];
+        // As above, but the DFA closures and table rows are computed by
+        // executor_. The state machine and warnings are identical to the
+        // serial build whatever the executor does.
+        static void build(rules& rules_, sm& sm_, executor& executor_,
+            std::string* warnings_ = 0, build_stats* stats_ = 0)
+        {
+            build_sm(rules_, sm_, executor_, warnings_, stats_);
+        }
 
-                    if (iter_->_index < p_._rhs._symbols.size())
-                    {
-                        const symbol& symbol_ = p_._rhs._symbols[iter_->_index];
-                        const std::size_t id_ =
-                            symbol_._type == symbol::TERMINAL ?
-                            symbol_._id : terminals_ + symbol_._id;
-                        typename size_t_vector::const_iterator sym_iter_ =
-                            std::find(symbols_.begin(), symbols_.end(), id_);
-                        cursor new_pair_(iter_->_id, iter_->_index + 1);
+        // Loads the state machine for rules_ from cache_dir_ if any process
+        // has already built it there, otherwise builds it and stores it.
+        // The file name is a fingerprint of everything build() reads from
+        // rules_, and the full fingerprint is checked on loading. Files are
+        // written under a temporary name and then renamed, so readers never
+        // see a partial machine. sm must be a type serialise.hpp can save.
+        static void build_cached(rules& rules_, sm& sm_,
+            const std::string& cache_dir_, std::string* warnings_ = 0)
+        {
+            std::string key_;
+            std::string warns_;
 
-                        if (sym_iter_ == symbols_.end())
-                        {
-                            symbols_.push_back(id_);
-                            item_sets_.push_back(cursor_vector());
-                            item_sets_.back().push_back(new_pair_);
-                        }
-                        else
-                        {
-                            const std::size_t index_ =
-                                sym_iter_ - symbols_.begin();
-                            cursor_vector& vec_ = item_sets_[index_];
-                            typename cursor_vector::const_iterator i_ =
-                                std::find(vec_.begin(), vec_.end(), new_pair_);
+            rules_.validate();
+            fingerprint(rules_, key_);
 
-                            if (i_ == vec_.end())
-                            {
-                                vec_.push_back(new_pair_);
-                            }
-                        }
-                    }
-                }
+            const std::string path_ = cache_dir_ + '/' +
+                hex(hash(key_)) + ".sm";
 
-                for (typename size_t_vector::const_iterator iter_ =
-                    symbols_.begin(), end_ = symbols_.end();
-                    iter_ != end_; ++iter_)
-                {
-                    std::size_t index_ = iter_ - symbols_.begin();
-                    cursor_vector& basis_ = item_sets_[index_];
+            if (!load_cached(path_, key_, sm_, warns_))
+            {
+                build(rules_, sm_, &warns_);
+                store_cached(path_, key_, sm_, warns_);
+            }
 
-                    std::sort(basis_.begin(), basis_.end());
-                    index_ = add_dfa_state(dfa_, hash_map_, basis_);
-                    state_._transitions.push_back(cursor(*iter_, index_));
-                }
+            // As build(), warnings are an error
+            // unless you are explicitly fetching them
+            if (!warns_.empty())
+            {
+                if (warnings_)
+                    *warnings_ = warns_;
+                else if (fatal(warns_))
+                    throw runtime_error(warns_);
             }
         }
 
+        static void build_dfa(rules& rules_, dfa& dfa_)
+        {
+            serial_executor executor_;
+
+            build_dfa(rules_, dfa_, executor_);
+        }
+
+        // The closure and goto sets of each batch of known states are
+        // computed by executor_. New states are then numbered by merging
+        // the batch in state order, exactly as a serial build would.
+        static void build_dfa(rules& rules_, dfa& dfa_, executor& executor_)
+        {
+            rules_.validate();
+            build_states(rules_, dfa_, executor_);
+        }
+
         static void rewrite(const rules& rules_, dfa& dfa_,
             prod_deque& new_grammar_, std::size_t& new_start_,
             nt_info_vector& new_nt_info_)
@@ -326,463 +337,2345 @@ namespace parsertl
                 nt_info(rules_.tokens_info().size()));
         }
 
-        // http://www.sqlite.org/src/artifact?ci=trunk&filename=tool/lemon.c
-        // FindFirstSets()
+        // Nullable and FIRST are computed with worklists: each non-terminal
+        // is revisited only when something it depends on has changed,
+        // rather than sweeping the whole grammar until nothing changes.
         static void build_first_sets(const prod_deque& grammar_,
             nt_info_vector& nt_info_)
         {
-            bool progress_ = true;
+            const std::size_t nt_count_ = nt_info_.size();
+            const std::size_t prod_count_ = grammar_.size();
+            // Number of rhs symbols not yet known to be nullable.
+            size_t_vector pending_(prod_count_, 0);
+            // Productions referencing each non-terminal (once per use).
+            std::vector<size_t_vector> users_(nt_count_);
+            size_t_vector worklist_;
 
             // First compute all lambdas
-            do
+            for (std::size_t p_ = 0; p_ < prod_count_; ++p_)
             {
-                progress_ = 0;
+                const symbol_vector& rhs_ = grammar_[p_]._rhs;
+                bool terminal_ = false;
 
-                for (typename prod_deque::const_iterator iter_ =
-                    grammar_.begin(), end_ = grammar_.end(); iter_ != end_;
-                    ++iter_)
+                for (typename symbol_vector::const_iterator iter_ =
+                    rhs_.begin(), end_ = rhs_.end(); iter_ != end_; ++iter_)
                 {
-                    if (nt_info_[iter_->_lhs]._nullable) continue;
+                    if (iter_->_type == symbol::TERMINAL)
+                    {
+                        terminal_ = true;
+                        break;
+                    }
+                }
 
-                    std::size_t i_ = 0;
-                    const std::size_t rhs_size_ = iter_->_rhs.size();
+                // A production containing a terminal can never be nullable.
+                if (terminal_) continue;
 
-                    for (; i_ < rhs_size_; i_++)
-                    {
-                        const symbol& symbol_ = iter_->_rhs[i_];
+                pending_[p_] = rhs_.size();
 
-                        if (symbol_._type != symbol::NON_TERMINAL ||
-                            !nt_info_[symbol_._id]._nullable)
-                        {
-                            break;
-                        }
-                    }
+                for (typename symbol_vector::const_iterator iter_ =
+                    rhs_.begin(), end_ = rhs_.end(); iter_ != end_; ++iter_)
+                {
+                    users_[iter_->_id].push_back(p_);
+                }
+
+                if (rhs_.empty())
+                {
+                    nt_info& lhs_info_ = nt_info_[grammar_[p_]._lhs];
 
-                    if (i_ == rhs_size_)
+                    if (!lhs_info_._nullable)
                     {
-                        nt_info_[iter_->_lhs]._nullable = true;
-                        progress_ = 1;
+                        lhs_info_._nullable = true;
+                        worklist_.push_back(grammar_[p_]._lhs);
                     }
                 }
-            } while (progress_);
+            }
 
-            // Now compute all first sets
-            do
+            while (!worklist_.empty())
             {
-                progress_ = 0;
+                const std::size_t id_ = worklist_.back();
+                const size_t_vector& users_of_ = users_[id_];
 
-                for (typename prod_deque::const_iterator iter_ =
-                    grammar_.begin(), end_ = grammar_.end(); iter_ != end_;
-                    ++iter_)
-                {
-                    nt_info& lhs_info_ = nt_info_[iter_->_lhs];
-                    const std::size_t rhs_size_ = iter_->_rhs.size();
+                worklist_.pop_back();
 
-                    for (std::size_t i_ = 0; i_ < rhs_size_; i_++)
+                for (typename size_t_vector::const_iterator iter_ =
+                    users_of_.begin(), end_ = users_of_.end();
+                    iter_ != end_; ++iter_)
+                {
+                    if (--pending_[*iter_] == 0)
                     {
-                        const symbol& symbol_ = iter_->_rhs[i_];
+                        const std::size_t lhs_ = grammar_[*iter_]._lhs;
 
-                        if (symbol_._type == symbol::TERMINAL)
-                        {
-                            progress_ |=
-                                set_add(lhs_info_._first_set, symbol_._id);
-                            break;
-                        }
-                        else if (iter_->_lhs == symbol_._id)
+                        if (!nt_info_[lhs_]._nullable)
                         {
-                            if (!lhs_info_._nullable) break;
+                            nt_info_[lhs_]._nullable = true;
+                            worklist_.push_back(lhs_);
                         }
-                        else
-                        {
-                            nt_info& rhs_info_ = nt_info_[symbol_._id];
+                    }
+                }
+            }
 
-                            progress_ |= set_union(lhs_info_._first_set,
-                                rhs_info_._first_set);
+            // Now compute all first sets.
+            // An edge X -> A means FIRST(X) flows into FIRST(A).
+            std::vector<size_t_vector> edges_(nt_count_);
 
-                            if (!rhs_info_._nullable) break;
-                        }
+            for (typename prod_deque::const_iterator iter_ =
+                grammar_.begin(), end_ = grammar_.end(); iter_ != end_;
+                ++iter_)
+            {
+                nt_info& lhs_info_ = nt_info_[iter_->_lhs];
+                const std::size_t rhs_size_ = iter_->_rhs.size();
+
+                for (std::size_t i_ = 0; i_ < rhs_size_; i_++)
+                {
+                    const symbol& symbol_ = iter_->_rhs[i_];
+
+                    if (symbol_._type == symbol::TERMINAL)
+                    {
+                        set_add(lhs_info_._first_set, symbol_._id);
+                        break;
+                    }
+                    else if (iter_->_lhs != symbol_._id)
+                    {
+                        edges_[symbol_._id].push_back(iter_->_lhs);
                     }
+
+                    if (!nt_info_[symbol_._id]._nullable) break;
                 }
-            } while (progress_);
+            }
+
+            propagate(edges_, nt_info_, &nt_info::_first_set);
         }
 
         static void build_follow_sets(const prod_deque& grammar_,
             nt_info_vector& nt_info_)
         {
-            for (;;)
+            // An edge A -> B means FOLLOW(A) flows into FOLLOW(B).
+            std::vector<size_t_vector> edges_(nt_info_.size());
+            typename prod_deque::const_iterator iter_ = grammar_.begin();
+            typename prod_deque::const_iterator end_ = grammar_.end();
+
+            for (; iter_ != end_; ++iter_)
             {
-                bool changes_ = false;
-                typename prod_deque::const_iterator iter_ = grammar_.begin();
-                typename prod_deque::const_iterator end_ = grammar_.end();
+                typename symbol_vector::const_iterator rhs_iter_ =
+                    iter_->_rhs.begin();
+                typename symbol_vector::const_iterator rhs_end_ =
+                    iter_->_rhs.end();
 
-                for (; iter_ != end_; ++iter_)
+                for (; rhs_iter_ != rhs_end_; ++rhs_iter_)
                 {
-                    typename symbol_vector::const_iterator rhs_iter_ =
-                        iter_->_rhs.begin();
-                    typename symbol_vector::const_iterator rhs_end_ =
-                        iter_->_rhs.end();
+                    if (rhs_iter_->_type != symbol::NON_TERMINAL) continue;
+
+                    nt_info& lhs_info_ = nt_info_[rhs_iter_->_id];
+                    typename symbol_vector::const_iterator next_iter_ =
+                        rhs_iter_ + 1;
 
-                    for (; rhs_iter_ != rhs_end_; ++rhs_iter_)
+                    // If there is a production A -> aBb
+                    // then everything in FIRST(b) is placed in FOLLOW(B).
+                    for (; next_iter_ != rhs_end_; ++next_iter_)
                     {
-                        if (rhs_iter_->_type == symbol::NON_TERMINAL)
+                        if (next_iter_->_type == symbol::TERMINAL)
                         {
-                            typename symbol_vector::const_iterator next_iter_ =
-                                rhs_iter_ + 1;
-                            nt_info& lhs_info_ = nt_info_[rhs_iter_->_id];
-                            bool nullable_ = next_iter_ == rhs_end_;
-
-                            if (next_iter_ != rhs_end_)
-                            {
-                                if (next_iter_->_type == symbol::TERMINAL)
-                                {
-                                    const std::size_t id_ = next_iter_->_id;
-
-                                    // Just add terminal.
-                                    changes_ |= set_add
-                                    (lhs_info_._follow_set, id_);
-                                }
-                                else
-                                {
-                                    // If there is a production A -> aBb
-                                    // then everything in FIRST(b) is
-                                    // placed in FOLLOW(B).
-                                    const nt_info* rhs_info_ =
-                                        &nt_info_[next_iter_->_id];
-
-                                    changes_ |= set_union(lhs_info_._follow_set,
-                                        rhs_info_->_first_set);
-                                    ++next_iter_;
-
-                                    // If nullable, keep going
-                                    if (rhs_info_->_nullable)
-                                    {
-                                        for (; next_iter_ != rhs_end_;
-                                            ++next_iter_)
-                                        {
-                                            std::size_t next_id_ =
-                                                static_cast<std::size_t>(~0);
-
-                                            if (next_iter_->_type ==
-                                                symbol::TERMINAL)
-                                            {
-                                                next_id_ = next_iter_->_id;
-                                                // Just add terminal.
-                                                changes_ |= set_add
-                                                (lhs_info_._follow_set,
-                                                    next_id_);
-                                                break;
-                                            }
-                                            else
-                                            {
-                                                next_id_ = next_iter_->_id;
-                                                rhs_info_ = &nt_info_[next_id_];
-                                                changes_ |= set_union
-                                                (lhs_info_._follow_set,
-                                                    rhs_info_->_first_set);
-
-                                                if (!rhs_info_->_nullable)
-                                                {
-                                                    break;
-                                                }
-                                            }
-                                        }
-
-                                        nullable_ = next_iter_ == rhs_end_;
-                                    }
-                                }
-                            }
+                            // Just add terminal.
+                            set_add(lhs_info_._follow_set, next_iter_->_id);
+                            break;
+                        }
+                        else
+                        {
+                            const nt_info& rhs_info_ =
+                                nt_info_[next_iter_->_id];
 
-                            if (nullable_)
-                            {
-                                // If there is a production A -> aB
-                                // then everything in FOLLOW(A) is in FOLLOW(B).
-                                const nt_info& rhs_info_ =
-                                    nt_info_[iter_->_lhs];
+                            set_union(lhs_info_._follow_set,
+                                rhs_info_._first_set);
 
-                                changes_ |= set_union(lhs_info_._follow_set,
-                                    rhs_info_._follow_set);
-                            }
+                            // If nullable, keep going
+                            if (!rhs_info_._nullable) break;
                         }
                     }
-                }
 
-                if (!changes_) break;
+                    // If there is a production A -> aB
+                    // then everything in FOLLOW(A) is in FOLLOW(B).
+                    if (next_iter_ == rhs_end_ &&
+                        iter_->_lhs != rhs_iter_->_id)
+                    {
+                        edges_[iter_->_lhs].push_back(rhs_iter_->_id);
+                    }
+                }
             }
-        }
 
-    private:
-        typedef typename sm::entry entry;
-        typedef typename rules::production_deque grammar;
-        typedef std::vector<std::size_t> size_t_vector;
-        typedef std::map<std::size_t, size_t_vector> hash_map;
-        typedef typename rules::string_vector string_vector;
-        typedef typename rules::symbol symbol;
-        typedef typename rules::token_info token_info;
-        typedef typename rules::token_info_vector token_info_vector;
+            propagate(edges_, nt_info_, &nt_info::_follow_set);
+        }
 
-        static void build_table(const rules& rules_, const dfa& dfa_,
+        // Collect the lookaheads of each reduction from the FOLLOW sets of
+        // the expanded grammar built by rewrite().
+        static void build_lookaheads(const rules& rules_, const dfa& dfa_,
             const prod_deque& new_grammar_, const nt_info_vector& new_nt_info_,
-            sm& sm_, std::string& warnings_)
+            lookahead_vector& lookaheads_)
         {
             const grammar& grammar_ = rules_.grammar();
-            const std::size_t start_ = rules_.start();
             const std::size_t terminals_ = rules_.tokens_info().size();
-            const std::size_t non_terminals_ = rules_.nt_locations().size();
-            string_vector symbols_;
-            const std::size_t columns_ = terminals_ + non_terminals_;
-            std::size_t index_ = 0;
 
-            rules_.symbols(symbols_);
-            sm_._columns = columns_;
-            sm_._rows = dfa_.size();
-            sm_.push();
+            lookaheads_.clear();
 
-            for (typename dfa::const_iterator iter_ = dfa_.begin(),
-                end_ = dfa_.end(); iter_ != end_; ++iter_, ++index_)
+            for (std::size_t index_ = 0, size_ = dfa_.size();
+                index_ != size_; ++index_)
             {
-                // shift and gotos
-                for (typename cursor_vector::const_iterator titer_ =
-                    iter_->_transitions.begin(),
-                    tend_ = iter_->_transitions.end();
-                    titer_ != tend_; ++titer_)
-                {
-                    const std::size_t id_ = titer_->_id;
-                    entry lhs_ = sm_.at(index_, id_);
-                    const entry rhs_((id_ < terminals_) ?
-                        // TERMINAL
-                        shift :
-                        // NON_TERMINAL
-                        go_to,
-                        static_cast<id_type>(titer_->_index));
-
-                    if (fill_entry(rules_, iter_->_closure, symbols_,
-                        lhs_, id_, rhs_, warnings_))
-                        sm_.set(index_, id_, lhs_);
-                }
+                const cursor_vector& closure_ = dfa_[index_]._closure;
 
-                // reductions
                 for (typename cursor_vector::const_iterator citer_ =
-                    iter_->_closure.begin(),
-                    cend_ = iter_->_closure.end(); citer_ != cend_; ++citer_)
+                    closure_.begin(), cend_ = closure_.end();
+                    citer_ != cend_; ++citer_)
                 {
                     const production& production_ = grammar_[citer_->_id];
 
-                    if (production_._rhs._symbols.size() == citer_->_index)
-                    {
-                        char_vector follow_set_(terminals_, 0);
-                        prod key_;
-
-                        key_._production = &production_;
-                        // Only the second value is relevant for the lookup
-                        key_._rhs_indexes.push_back(cursor(index_, index_));
+                    if (production_._rhs._symbols.size() != citer_->_index)
+                        continue;
 
-                        // config is reduction
-                        for (typename prod_deque::const_iterator ng_iter_ =
-                            std::lower_bound(new_grammar_.begin(),
-                                new_grammar_.end(), key_),
-                            ng_end_ = new_grammar_.end();
-                            ng_iter_ != ng_end_; ++ng_iter_)
-                        {
-                            if (production_._lhs ==
-                                ng_iter_->_production->_lhs &&
-                                production_._rhs ==
-                                ng_iter_->_production->_rhs &&
-                                index_ == ng_iter_->_rhs_indexes.back()._index)
-                            {
-                                const std::size_t lhs_id_ = ng_iter_->_lhs;
+                    prod key_;
 
-                                set_union(follow_set_,
-                                    new_nt_info_[lhs_id_]._follow_set);
-                            }
-                            else
-                                break;
-                        }
+                    lookaheads_.push_back(bit_vector(terminals_));
+                    key_._production = &production_;
+                    // Only the second value is relevant for the lookup
+                    key_._rhs_indexes.push_back(cursor(index_, index_));
 
-                        for (std::size_t id_ = 0, size_ = follow_set_.size();
-                            id_ < size_; ++id_)
+                    for (typename prod_deque::const_iterator ng_iter_ =
+                        std::lower_bound(new_grammar_.begin(),
+                            new_grammar_.end(), key_),
+                        ng_end_ = new_grammar_.end();
+                        ng_iter_ != ng_end_; ++ng_iter_)
+                    {
+                        if (production_._lhs ==
+                            ng_iter_->_production->_lhs &&
+                            production_._rhs ==
+                            ng_iter_->_production->_rhs &&
+                            index_ == ng_iter_->_rhs_indexes.back()._index)
                         {
-                            if (!follow_set_[id_]) continue;
-
-                            entry lhs_ = sm_.at(index_, id_);
-                            const entry rhs_(production_._lhs == start_ ?
-                                accept :
-                                reduce,
-                                static_cast<id_type>(production_._index));
+                            const std::size_t lhs_id_ = ng_iter_->_lhs;
 
-                            if (fill_entry(rules_, iter_->_closure, symbols_,
-                                lhs_, id_, rhs_, warnings_))
-                                sm_.set(index_, id_, lhs_);
+                            set_union(lookaheads_.back(),
+                                new_nt_info_[lhs_id_]._follow_set);
                         }
+                        else
+                            break;
                     }
                 }
             }
         }
 
-        static void copy_rules(const rules& rules_, sm& sm_)
+        // DeRemer and Pennello, "Efficient Computation of LALR(1)
+        // Look-Ahead Sets" (1982). Works directly on the LR(0) automaton
+        // via the reads, includes and lookback relations, without building
+        // the expanded grammar. The results match the overload above.
+        static void build_lookaheads(const rules& rules_, const dfa& dfa_,
+            lookahead_vector& lookaheads_)
         {
             const grammar& grammar_ = rules_.grammar();
+            const typename rules::nt_location_vector& nt_locations_ =
+                rules_.nt_locations();
             const std::size_t terminals_ = rules_.tokens_info().size();
-            typename grammar::const_iterator iter_ = grammar_.begin();
-            typename grammar::const_iterator end_ = grammar_.end();
-
-            for (; iter_ != end_; ++iter_)
+            const std::size_t start_ = rules_.start();
+            const std::size_t states_ = dfa_.size();
+            char_vector nullable_;
+            // Non-terminal transitions are numbered in state order;
+            // those leaving state p are [first_nt_[p], first_nt_[p + 1]).
+            size_t_vector first_nt_(states_ + 1, 0);
+            size_t_vector nt_symbol_;
+            size_t_vector nt_goto_;
+            std::vector<size_t_vector> reads_;
+            std::vector<size_t_vector> includes_;
+            lookahead_vector follow_;
+            // ((state, production), transition)
+            std::vector<std::pair<cursor, std::size_t> > lookback_;
+
+            build_nullable(rules_, nullable_);
+
+            for (std::size_t p_ = 0; p_ < states_; ++p_)
             {
-                const production& production_ = *iter_;
-                typename symbol_vector::const_iterator rhs_iter_ =
-                    production_._rhs._symbols.begin();
-                typename symbol_vector::const_iterator rhs_end_ =
-                    production_._rhs._symbols.end();
-
-                sm_._rules.push_back(typename sm::id_type_vector_pair());
-
-                typename sm::id_type_vector_pair& pair_ = sm_._rules.back();
+                const cursor_vector& transitions_ = dfa_[p_]._transitions;
 
-                pair_._lhs = static_cast<id_type>(terminals_ +
-                    production_._lhs);
+                first_nt_[p_] = nt_symbol_.size();
 
-                for (; rhs_iter_ != rhs_end_; ++rhs_iter_)
+                for (typename cursor_vector::const_iterator iter_ =
+                    transitions_.begin(), end_ = transitions_.end();
+                    iter_ != end_; ++iter_)
                 {
-                    const symbol& symbol_ = *rhs_iter_;
-
-                    if (symbol_._type == symbol::TERMINAL)
-                    {
-                        pair_._rhs.push_back(static_cast
-                            <id_type>(symbol_._id));
-                    }
-                    else
+                    if (iter_->_id >= terminals_)
                     {
-                        pair_._rhs.push_back(static_cast
-                            <id_type>(terminals_ + symbol_._id));
+                        nt_symbol_.push_back(iter_->_id - terminals_);
+                        nt_goto_.push_back(iter_->_index);
                     }
                 }
             }
-        }
-
-        // Helper functions:
-
-        // Add a new element to the set. Return true if the element was added
-        // and false if it was already there.
-        static bool set_add(char_vector& s_, const std::size_t e_)
-        {
-            const char rv_ = s_[e_];
-
-            assert(e_ < s_.size());
-            s_[e_] = 1;
-            return !rv_;
-        }
 
-        // Add every element of rhs_ to lhs_. Return true if lhs_ changes.
-        static bool set_union(char_vector& lhs_, const char_vector& rhs_)
-        {
-            const std::size_t size_ = lhs_.size();
-            bool progress_ = false;
-            char* lhs_ptr_ = &lhs_.front();
-            const char* rhs_ptr_ = &rhs_.front();
+            first_nt_[states_] = nt_symbol_.size();
+            follow_.assign(nt_symbol_.size(), bit_vector(terminals_));
+            reads_.resize(nt_symbol_.size());
+            includes_.resize(nt_symbol_.size());
 
-            for (std::size_t i_ = 0; i_ < size_; i_++)
+            // DR(p, A) is every terminal shifted by goto(p, A) and
+            // (p, A) reads (r, C) when r = goto(p, A) and C is nullable.
+            for (std::size_t x_ = 0, size_ = nt_symbol_.size();
+                x_ < size_; ++x_)
             {
-                if (rhs_ptr_[i_] == 0) continue;
+                const std::size_t r_ = nt_goto_[x_];
+                const cursor_vector& transitions_ = dfa_[r_]._transitions;
 
-                if (lhs_ptr_[i_] == 0)
+                for (typename cursor_vector::const_iterator iter_ =
+                    transitions_.begin(), end_ = transitions_.end();
+                    iter_ != end_; ++iter_)
                 {
-                    progress_ = true;
-                    lhs_ptr_[i_] = 1;
+                    if (iter_->_id < terminals_)
+                    {
+                        follow_[x_].set(iter_->_id);
+                    }
                 }
-            }
 
-            return progress_;
-        }
+                for (std::size_t y_ = first_nt_[r_]; y_ < first_nt_[r_ + 1];
+                    ++y_)
+                {
+                    if (nullable_[nt_symbol_[y_]])
+                    {
+                        reads_[x_].push_back(y_);
+                    }
+                }
+            }
 
-        static void closure(const rules& rules_, dfa_state& state_)
-        {
-            const typename rules::nt_location_vector& nt_locations_ =
-                rules_.nt_locations();
-            const grammar& grammar_ = rules_.grammar();
+            // follow_ becomes Read(p, A).
+            digraph(reads_, follow_);
 
-            for (std::size_t c_ = 0; c_ < state_._closure.size(); ++c_)
+            // For each transition (p, B) and production B -> w, walk w
+            // from p. (s, A) includes (p, B) when B -> vAu, u is nullable
+            // and v leads from p to s. The walk ends in the state q
+            // where B -> w is reduced: (q, B -> w) lookback (p, B).
+            for (std::size_t p_ = 0; p_ < states_; ++p_)
             {
-                const cursor pair_ = state_._closure[c_];
-                const production* p_ = &grammar_[pair_._id];
-                const std::size_t rhs_size_ = p_->_rhs._symbols.size();
-
-                if (pair_._index < rhs_size_)
+                for (std::size_t x_ = first_nt_[p_]; x_ < first_nt_[p_ + 1];
+                    ++x_)
                 {
-                    // SHIFT
-                    const symbol& symbol_ = p_->_rhs._symbols[pair_._index];
-
-                    if (symbol_._type == symbol::NON_TERMINAL)
+                    for (std::size_t rule_ =
+                        nt_locations_[nt_symbol_[x_]]._first_production;
+                        rule_ != npos(); rule_ = grammar_[rule_]._next_lhs)
                     {
-                        for (std::size_t rule_ =
-                            nt_locations_[symbol_._id]._first_production;
-                            rule_ != npos(); rule_ = grammar_[rule_]._next_lhs)
+                        const symbol_vector& rhs_ =
+                            grammar_[rule_]._rhs._symbols;
+                        std::size_t nullable_from_ = rhs_.size();
+                        std::size_t state_ = p_;
+
+                        while (nullable_from_ > 0 &&
+                            rhs_[nullable_from_ - 1]._type ==
+                                symbol::NON_TERMINAL &&
+                            nullable_[rhs_[nullable_from_ - 1]._id])
                         {
-                            const cursor new_pair_(rule_, 0);
-                            typename cursor_vector::const_iterator i_ =
-                                std::find(state_._closure.begin(),
-                                    state_._closure.end(), new_pair_);
+                            --nullable_from_;
+                        }
+
+                        for (std::size_t i_ = 0, size_ = rhs_.size();
+                            i_ < size_; ++i_)
+                        {
+                            const symbol& symbol_ = rhs_[i_];
 
-                            if (i_ == state_._closure.end())
+                            if (symbol_._type == symbol::TERMINAL)
                             {
-                                state_._closure.push_back(new_pair_);
+                                state_ = find_goto(dfa_[state_], symbol_._id);
+                                continue;
                             }
-                        }
+
+                            std::size_t y_ = first_nt_[state_];
+
+                            while (nt_symbol_[y_] != symbol_._id) ++y_;
+
+                            if (i_ + 1 >= nullable_from_)
+                            {
+                                includes_[y_].push_back(x_);
+                            }
+
+                            state_ = nt_goto_[y_];
+                        }
+
+                        lookback_.push_back(std::make_pair
+                            (cursor(state_, rule_), x_));
+                    }
+                }
+            }
+
+            // follow_ becomes Follow(p, A).
+            digraph(includes_, follow_);
+            std::sort(lookback_.begin(), lookback_.end());
+            lookaheads_.clear();
+
+            // LA(q, A -> w) is the union of Follow(p, A) over lookback.
+            for (std::size_t q_ = 0; q_ < states_; ++q_)
+            {
+                const cursor_vector& closure_ = dfa_[q_]._closure;
+
+                for (typename cursor_vector::const_iterator citer_ =
+                    closure_.begin(), cend_ = closure_.end();
+                    citer_ != cend_; ++citer_)
+                {
+                    const production& production_ = grammar_[citer_->_id];
+
+                    if (production_._rhs._symbols.size() != citer_->_index)
+                        continue;
+
+                    const cursor key_(q_, citer_->_id);
+
+                    lookaheads_.push_back(bit_vector(terminals_));
+
+                    // $accept is only ever reduced on EOF.
+                    if (production_._lhs == start_)
+                    {
+                        lookaheads_.back().set(0);
+                        continue;
+                    }
+
+                    for (typename std::vector<std::pair<cursor, std::size_t> >::
+                        const_iterator iter_ = std::lower_bound(lookback_.
+                            begin(), lookback_.end(), std::make_pair(key_,
+                                static_cast<std::size_t>(0))),
+                        end_ = lookback_.end();
+                        iter_ != end_ && iter_->first == key_; ++iter_)
+                    {
+                        set_union(lookaheads_.back(), follow_[iter_->second]);
+                    }
+                }
+            }
+        }
+
+        // SLR(1): each reduction A -> w takes FOLLOW(A) from the original
+        // grammar. This skips rewrite() but can add conflicts that LALR(1)
+        // lookaheads would not have.
+        static void build_slr_lookaheads(const rules& rules_, const dfa& dfa_,
+            lookahead_vector& lookaheads_)
+        {
+            const grammar& grammar_ = rules_.grammar();
+            const std::size_t terminals_ = rules_.tokens_info().size();
+            prod_deque prods_;
+            nt_info_vector nt_info_(rules_.nt_locations().size(),
+                nt_info(terminals_));
+
+            for (typename grammar::const_iterator iter_ = grammar_.begin(),
+                end_ = grammar_.end(); iter_ != end_; ++iter_)
+            {
+                prods_.push_back(prod());
+                prods_.back()._production = &*iter_;
+                prods_.back()._lhs = iter_->_lhs;
+                prods_.back()._rhs = iter_->_rhs._symbols;
+            }
+
+            build_first_sets(prods_, nt_info_);
+            // First add EOF to follow_set of start.
+            nt_info_[rules_.start()]._follow_set.set(0);
+            build_follow_sets(prods_, nt_info_);
+            lookaheads_.clear();
+
+            for (typename dfa::const_iterator iter_ = dfa_.begin(),
+                end_ = dfa_.end(); iter_ != end_; ++iter_)
+            {
+                for (typename cursor_vector::const_iterator citer_ =
+                    iter_->_closure.begin(), cend_ = iter_->_closure.end();
+                    citer_ != cend_; ++citer_)
+                {
+                    const production& production_ = grammar_[citer_->_id];
+
+                    if (production_._rhs._symbols.size() == citer_->_index)
+                    {
+                        lookaheads_.push_back
+                            (nt_info_[production_._lhs]._follow_set);
+                    }
+                }
+            }
+        }
+
+    private:
+        typedef typename sm::entry entry;
+        typedef std::vector<entry> entry_vector;
+        typedef typename rules::production_deque grammar;
+        typedef std::vector<std::size_t> size_t_vector;
+        typedef typename rules::string_vector string_vector;
+        typedef typename rules::symbol symbol;
+        typedef typename rules::token_info token_info;
+        typedef typename rules::token_info_vector token_info_vector;
+        typedef basic_state_machine<typename sm::id_type> unit_sm;
+        typedef typename unit_sm::state_pair state_pair;
+        typedef typename unit_sm::pair_vector pair_vector;
+        typedef std::map<size_t_vector, std::size_t> merge_map;
+        // (lookahead index, token) of each conflict settled by precedence
+        typedef std::vector<std::pair<std::size_t, std::size_t> > cell_vector;
+
+        template<typename sm_type>
+        static void build_sm(rules& rules_, sm_type& sm_,
+            executor& executor_, std::string* warnings_, build_stats* stats_)
+        {
+            build_sm(rules_, sm_, sm_, executor_, warnings_, stats_);
+        }
+
+        // The classed state machine is grouped from a complete sparse
+        // table (see assign_table()) rather than filled as a dense table.
+        static void build_sm(rules& rules_,
+            basic_classed_state_machine<typename sm::id_type>& sm_,
+            executor& executor_, std::string* warnings_, build_stats* stats_)
+        {
+            unit_sm table_;
+
+            build_sm(rules_, sm_, table_, executor_, warnings_, stats_);
+        }
+
+        // The CSR state machine is converted from a complete sparse table
+        // (see assign_table()), as set() costs O(rows) per new cell.
+        static void build_sm(rules& rules_,
+            basic_csr_state_machine<typename sm::id_type>& sm_,
+            executor& executor_, std::string* warnings_, build_stats* stats_)
+        {
+            unit_sm table_;
+
+            build_sm(rules_, sm_, table_, executor_, warnings_, stats_);
+        }
+
+        // The comb state machine is packed from a complete sparse table
+        // (see assign_table()) as set() moves a row each time it collides
+        // with another.
+        static void build_sm(rules& rules_,
+            basic_comb_state_machine<typename sm::id_type>& sm_,
+            executor& executor_, std::string* warnings_, build_stats* stats_)
+        {
+            unit_sm table_;
+
+            build_sm(rules_, sm_, table_, executor_, warnings_, stats_);
+        }
+
+        // The split state machine is also built from a complete sparse
+        // table (see assign_table()) so that each non-terminal gets its
+        // default goto. set() has no way to pick one.
+        static void build_sm(rules& rules_,
+            basic_split_state_machine<typename sm::id_type>& sm_,
+            executor& executor_, std::string* warnings_, build_stats* stats_)
+        {
+            unit_sm table_;
+
+            build_sm(rules_, sm_, table_, executor_, warnings_, stats_);
+        }
+
+        // Builds the table in table_, which is either sm_ itself or a
+        // basic_state_machine assigned to sm_ once complete.
+        template<typename table_type>
+        static void build_sm(rules& rules_, sm& sm_, table_type& table_,
+            executor& executor_, std::string* warnings_, build_stats* stats_)
+        {
+            dfa dfa_;
+            lookahead_vector lookaheads_;
+            std::string warns_;
+            // SLR(1) only conflicts, for information as the LALR(1) table
+            // is used instead.
+            std::string slr_warns_;
+            double time_ = 0;
+
+            if (stats_)
+            {
+                stats_->clear();
+                time_ = stats_->now();
+            }
+
+            rules_.validate();
+            lap(stats_, build_stats::validate_phase, time_);
+            build_states(rules_, dfa_, executor_);
+            lap(stats_, build_stats::dfa_phase, time_);
+            check_id_type(rules_, dfa_.size());
+
+            if (stats_)
+            {
+                stats_->_states = dfa_.size();
+                stats_->_bytes[build_stats::dfa_phase] =
+                    size_of(dfa_, stats_->_closure_items);
+            }
+
+            if (rules_.flags() & enable_slr_lookaheads)
+            {
+                std::vector<std::string> slr_rows_;
+                cell_vector resolved_;
+
+                build_slr_lookaheads(rules_, dfa_, lookaheads_);
+                lap(stats_, build_stats::lookahead_phase, time_);
+                fill_table(rules_, dfa_, lookaheads_, table_, warns_,
+                    executor_, &slr_rows_, &resolved_, stats_);
+
+                // Fall back to LALR(1) if the SLR(1) table has conflicts,
+                // reporting any that LALR(1) does not have. A conflict
+                // settled by precedence needs the LALR(1) lookaheads to
+                // check it: if its token is not in the LALR(1) lookahead
+                // of the reduction, LALR(1) shifts where SLR(1) may not.
+                if (!warns_.empty() || !resolved_.empty())
+                {
+                    lookahead_vector lalr_;
+
+                    lap(stats_, build_stats::table_phase, time_);
+                    build_lookaheads(rules_, dfa_, lalr_);
+                    lap(stats_, build_stats::lookahead_phase, time_);
+                    lookaheads_.swap(lalr_);
+
+                    if (!warns_.empty() ||
+                        !in_lookaheads(resolved_, lookaheads_))
+                    {
+                        std::vector<std::string> lalr_rows_;
+
+                        warns_.clear();
+                        fill_table(rules_, dfa_, lookaheads_, table_, warns_,
+                            executor_, &lalr_rows_, 0, stats_);
+                        slr_conflicts(slr_rows_, lalr_rows_, slr_warns_);
+                    }
+                }
+            }
+            else if (rules_.flags() & enable_deremer_pennello)
+                build_lookaheads(rules_, dfa_, lookaheads_);
+            else
+            {
+                prod_deque new_grammar_;
+                std::size_t new_start_ = static_cast<std::size_t>(~0);
+                nt_info_vector new_nt_info_;
+
+                rewrite(rules_, dfa_, new_grammar_, new_start_, new_nt_info_);
+                lap(stats_, build_stats::rewrite_phase, time_);
+                build_first_sets(new_grammar_, new_nt_info_);
+                lap(stats_, build_stats::first_sets_phase, time_);
+                // First add EOF to follow_set of start.
+                new_nt_info_[new_start_]._follow_set.set(0);
+                build_follow_sets(new_grammar_, new_nt_info_);
+                lap(stats_, build_stats::follow_sets_phase, time_);
+                // new_grammar_ is only used for lookup now
+                // so sort in order that std::lower_bound() can be used.
+                std::sort(new_grammar_.begin(), new_grammar_.end());
+                lap(stats_, build_stats::sort_phase, time_);
+                build_lookaheads(rules_, dfa_, new_grammar_, new_nt_info_,
+                    lookaheads_);
+
+                if (stats_)
+                {
+                    stats_->_rewritten_non_terminals = new_nt_info_.size();
+                    stats_->_bytes[build_stats::rewrite_phase] =
+                        size_of(new_grammar_);
+                    stats_->_bytes[build_stats::first_sets_phase] =
+                        size_of(new_nt_info_, &nt_info::_first_set);
+                    stats_->_bytes[build_stats::follow_sets_phase] =
+                        size_of(new_nt_info_, &nt_info::_follow_set);
+                }
+            }
+
+            if (stats_)
+            {
+                stats_->_bytes[build_stats::lookahead_phase] =
+                    size_of(lookaheads_);
+            }
+
+            if (!(rules_.flags() & enable_slr_lookaheads))
+            {
+                lap(stats_, build_stats::lookahead_phase, time_);
+                fill_table(rules_, dfa_, lookaheads_, table_, warns_,
+                    executor_, 0, 0, stats_);
+            }
+
+            lap(stats_, build_stats::table_phase, time_);
+
+            if (rules_.flags() & enable_default_reductions)
+                build_default_reductions(table_);
+
+            assign_table(table_, sm_);
+            lap(stats_, build_stats::compress_phase, time_);
+
+            // Warnings are now an error
+            // unless you are explicitly fetching them
+            if (!warns_.empty() || !slr_warns_.empty())
+            {
+                if (warnings_)
+                    *warnings_ = warns_ + slr_warns_;
+                else if (!warns_.empty())
+                    throw runtime_error(warns_);
+            }
+
+            copy_rules(rules_, sm_);
+            sm_._captures = rules_.captures();
+            lap(stats_, build_stats::copy_rules_phase, time_);
+        }
+
+        // Adds the time since time_ to phase_ and restarts time_.
+        static void lap(build_stats* stats_,
+            const typename build_stats::phase phase_, double& time_)
+        {
+            if (stats_)
+            {
+                const double now_ = stats_->now();
+
+                stats_->_seconds[phase_] += now_ - time_;
+                time_ = now_;
+            }
+        }
+
+        static std::size_t size_of(const dfa& dfa_, std::size_t& items_)
+        {
+            std::size_t bytes_ = dfa_.size() * sizeof(dfa_state);
+
+            items_ = 0;
+
+            for (typename dfa::const_iterator iter_ = dfa_.begin(),
+                end_ = dfa_.end(); iter_ != end_; ++iter_)
+            {
+                items_ += iter_->_closure.size();
+                bytes_ += (iter_->_closure.capacity() +
+                    iter_->_transitions.capacity()) * sizeof(cursor);
+            }
+
+            return bytes_;
+        }
+
+        static std::size_t size_of(const prod_deque& grammar_)
+        {
+            std::size_t bytes_ = grammar_.size() * sizeof(prod);
+
+            for (typename prod_deque::const_iterator iter_ =
+                grammar_.begin(), end_ = grammar_.end();
+                iter_ != end_; ++iter_)
+            {
+                bytes_ += iter_->_rhs.capacity() * sizeof(symbol) +
+                    iter_->_rhs_indexes.capacity() * sizeof(cursor);
+            }
+
+            return bytes_;
+        }
+
+        static std::size_t size_of(const nt_info_vector& nt_info_,
+            bit_vector nt_info::* set_)
+        {
+            std::size_t bytes_ = 0;
+
+            for (typename nt_info_vector::const_iterator iter_ =
+                nt_info_.begin(), end_ = nt_info_.end();
+                iter_ != end_; ++iter_)
+            {
+                bytes_ += size_of((*iter_).*set_);
+            }
+
+            return bytes_;
+        }
+
+        static std::size_t size_of(const lookahead_vector& lookaheads_)
+        {
+            std::size_t bytes_ = 0;
+
+            for (typename lookahead_vector::const_iterator iter_ =
+                lookaheads_.begin(), end_ = lookaheads_.end();
+                iter_ != end_; ++iter_)
+            {
+                bytes_ += size_of(*iter_);
+            }
+
+            return bytes_;
+        }
+
+        static std::size_t size_of(const bit_vector& set_)
+        {
+            return (set_.size() + bit_vector::word_bits - 1) /
+                bit_vector::word_bits * sizeof(bit_vector::word);
+        }
+
+        // Everything in rules_ that the state machine depends on, as text.
+        // Names are left out as the state machine only holds ids.
+        static void fingerprint(const rules& rules_, std::string& key_)
+        {
+            const grammar& grammar_ = rules_.grammar();
+            const token_info_vector& tokens_info_ = rules_.tokens_info();
+            const typename rules::captures_deque& captures_ =
+                rules_.captures();
+            std::ostringstream ss_;
+
+            ss_ << "parsertl 1 " << sizeof(typename sm::id_type) << ' ' <<
+                rules_.flags() << ' ' << rules_.start() << ' ' <<
+                rules_.nt_locations().size() << ' ' << tokens_info_.size();
+
+            for (typename token_info_vector::const_iterator iter_ =
+                tokens_info_.begin(), end_ = tokens_info_.end();
+                iter_ != end_; ++iter_)
+            {
+                ss_ << ' ' << iter_->_precedence << ' ' <<
+                    static_cast<int>(iter_->_associativity);
+            }
+
+            ss_ << ' ' << grammar_.size();
+
+            for (typename grammar::const_iterator iter_ = grammar_.begin(),
+                end_ = grammar_.end(); iter_ != end_; ++iter_)
+            {
+                ss_ << ' ' << iter_->_lhs << ' ' << iter_->_precedence <<
+                    ' ' << static_cast<int>(iter_->_associativity) << ' ' <<
+                    iter_->_keep << ' ' << iter_->_rhs._symbols.size();
+
+                for (typename symbol_vector::const_iterator sym_iter_ =
+                    iter_->_rhs._symbols.begin(),
+                    sym_end_ = iter_->_rhs._symbols.end();
+                    sym_iter_ != sym_end_; ++sym_iter_)
+                {
+                    ss_ << ' ' << static_cast<int>(sym_iter_->_type) <<
+                        ' ' << sym_iter_->_id;
+                }
+            }
+
+            ss_ << ' ' << captures_.size();
+
+            for (typename rules::captures_deque::const_iterator iter_ =
+                captures_.begin(), end_ = captures_.end();
+                iter_ != end_; ++iter_)
+            {
+                ss_ << ' ' << iter_->first << ' ' << iter_->second.size();
+
+                for (typename rules::capture_vector::const_iterator
+                    pair_iter_ = iter_->second.begin(),
+                    pair_end_ = iter_->second.end();
+                    pair_iter_ != pair_end_; ++pair_iter_)
+                {
+                    ss_ << ' ' << pair_iter_->first << ' ' <<
+                        pair_iter_->second;
+                }
+            }
+
+            key_ = ss_.str();
+        }
+
+        static std::size_t hash(const std::string& str_)
+        {
+            std::size_t hash_ = str_.size();
+
+            for (std::string::const_iterator iter_ = str_.begin(),
+                end_ = str_.end(); iter_ != end_; ++iter_)
+            {
+                kernel_table::combine(hash_, static_cast<unsigned char>
+                    (*iter_));
+            }
+
+            return hash_;
+        }
+
+        static std::string hex(std::size_t num_)
+        {
+            std::ostringstream ss_;
+
+            ss_ << std::hex << num_;
+            return ss_.str();
+        }
+
+        // True if warnings_ has a line other than the "SLR(1) " conflicts
+        // that build() reports without treating them as an error.
+        static bool fatal(const std::string& warnings_)
+        {
+            const std::string prefix_("SLR(1) ");
+
+            for (std::size_t begin_ = 0, end_ = 0;
+                begin_ < warnings_.size(); begin_ = end_)
+            {
+                end_ = warnings_.find('\n', begin_);
+                end_ = end_ == std::string::npos ?
+                    warnings_.size() : end_ + 1;
+
+                if (warnings_.compare(begin_, prefix_.size(), prefix_) != 0)
+                    return true;
+            }
+
+            return false;
+        }
+
+        // A cache file holds the fingerprint, the warnings and then the
+        // state machine. Anything unreadable or for another fingerprint
+        // is a miss.
+        static bool load_cached(const std::string& path_,
+            const std::string& key_, sm& sm_, std::string& warnings_)
+        {
+            std::ifstream is_(path_.c_str(), std::ios::binary);
+            std::string key2_;
+
+            if (!is_ || !read_string(is_, key2_) || key2_ != key_ ||
+                !read_string(is_, warnings_))
+            {
+                return false;
+            }
+
+            try
+            {
+                load(is_, sm_);
+            }
+            catch (const std::exception&)
+            {
+                is_.setstate(std::ios::failbit);
+            }
+
+            if (!is_)
+            {
+                sm_.clear();
+                warnings_.clear();
+                return false;
+            }
+
+            return true;
+        }
+
+        // Failing to store is not an error, the next build just misses.
+        static void store_cached(const std::string& path_,
+            const std::string& key_, const sm& sm_,
+            const std::string& warnings_)
+        {
+            // Its address tells this writer apart from any other
+            // running in this process.
+            const std::vector<char> tag_(1);
+            const std::string temp_ = temp_name(path_, &tag_.front());
+            std::streamoff size_ = -1;
+
+            {
+                std::ofstream os_(temp_.c_str(), std::ios::binary);
+
+                if (os_)
+                {
+                    os_ << key_.size() << '\n' << key_ << '\n';
+                    os_ << warnings_.size() << '\n' << warnings_ << '\n';
+                    save(sm_, os_);
+                    size_ = os_.tellp();
+                    os_.close();
+
+                    if (os_.fail())
+                    {
+                        size_ = -1;
+                    }
+                }
+            }
+
+            // Should another writer have picked the same name after all,
+            // the file is no longer ours and must not be published.
+            if (size_ < 0 || !written(temp_, key_, size_) ||
+                std::rename(temp_.c_str(), path_.c_str()) != 0)
+            {
+                // Another process may have stored the same machine first.
+                std::remove(temp_.c_str());
+            }
+        }
+
+        // Mixes a per process counter and the address of tag_, which
+        // separate writers within a process, with the time and clock,
+        // which separate processes. Names already in use are skipped.
+        static std::string temp_name(const std::string& path_,
+            const char* tag_)
+        {
+            static std::size_t counter_ = 0;
+            std::size_t id_ = reinterpret_cast<std::size_t>(tag_);
+
+            kernel_table::combine(id_, static_cast<std::size_t>
+                (std::time(0)));
+
+            for (;;)
+            {
+                kernel_table::combine(id_, ++counter_);
+                kernel_table::combine(id_, static_cast<std::size_t>
+                    (std::clock()));
+
+                const std::string temp_ = path_ + '.' + hex(id_) + ".tmp";
+                std::ifstream is_(temp_.c_str(), std::ios::binary);
+
+                if (!is_)
+                {
+                    return temp_;
+                }
+            }
+        }
+
+        // True if path_ still holds what this writer stored: key_ and
+        // size_ bytes in all.
+        static bool written(const std::string& path_,
+            const std::string& key_, const std::streamoff size_)
+        {
+            std::ifstream is_(path_.c_str(), std::ios::binary);
+            std::string key2_;
+
+            if (!is_ || !read_string(is_, key2_) || key2_ != key_ ||
+                !is_.seekg(0, std::ios::end))
+            {
+                return false;
+            }
+
+            return static_cast<std::streamoff>(is_.tellg()) == size_;
+        }
+
+        static bool read_string(std::istream& is_, std::string& str_)
+        {
+            std::size_t size_ = 0;
+
+            if (!(is_ >> size_) || is_.get() != '\n')
+            {
+                return false;
+            }
+
+            str_.resize(size_);
+
+            if (size_ && !is_.read(&str_[0], size_))
+            {
+                return false;
+            }
+
+            return is_.get() == '\n';
+        }
+
+        // Builds the table from the lookaheads, applying unit elimination
+        // if enabled. Each row's warnings go in row_warnings_ and each
+        // conflict settled by precedence goes in resolved_ if not null.
+        template<typename sm_type>
+        static void fill_table(const rules& rules_, const dfa& dfa_,
+            const lookahead_vector& lookaheads_, sm_type& sm_,
+            std::string& warnings_, executor& executor_,
+            std::vector<std::string>* row_warnings_, cell_vector* resolved_,
+            build_stats* stats_)
+        {
+            sm_.clear();
+
+            if (rules_.flags() & enable_unit_elimination)
+            {
+                unit_sm unit_sm_;
+
+                build_table(rules_, dfa_, lookaheads_, unit_sm_, warnings_,
+                    executor_, row_warnings_, resolved_, stats_);
+                eliminate_units(rules_, unit_sm_);
+                check_id_type(rules_, unit_sm_._rows);
+                copy_table(unit_sm_, sm_);
+            }
+            else
+                build_table(rules_, dfa_, lookaheads_, sm_, warnings_,
+                    executor_, row_warnings_, resolved_, stats_);
+        }
+
+        // True if the token of each cell is in the lookahead set of its
+        // reduction.
+        static bool in_lookaheads(const cell_vector& cells_,
+            const lookahead_vector& lookaheads_)
+        {
+            for (typename cell_vector::const_iterator iter_ = cells_.begin(),
+                end_ = cells_.end(); iter_ != end_; ++iter_)
+            {
+                if (!lookaheads_[iter_->first].test(iter_->second))
+                    return false;
+            }
+
+            return true;
+        }
+
+        // Appends each SLR(1) warning that the same row does not have
+        // under LALR(1), prefixed with "SLR(1) ".
+        static void slr_conflicts(const std::vector<std::string>& slr_rows_,
+            const std::vector<std::string>& lalr_rows_,
+            std::string& warnings_)
+        {
+            for (std::size_t index_ = 0, size_ = slr_rows_.size();
+                index_ < size_; ++index_)
+            {
+                const std::string& slr_ = slr_rows_[index_];
+                std::string lalr_ = lalr_rows_[index_];
+
+                if (slr_ == lalr_) continue;
+
+                for (std::size_t begin_ = 0, end_ = 0;
+                    begin_ < slr_.size(); begin_ = end_)
+                {
+                    end_ = slr_.find('\n', begin_);
+                    end_ = end_ == std::string::npos ? slr_.size() : end_ + 1;
+
+                    const std::string line_ = slr_.substr(begin_,
+                        end_ - begin_);
+                    const std::size_t pos_ = lalr_.find(line_);
+
+                    // Each LALR(1) warning accounts for one SLR(1) warning.
+                    if (pos_ == std::string::npos)
+                        warnings_ += "SLR(1) " + line_;
+                    else
+                        lalr_.erase(pos_, line_.size());
+                }
+            }
+        }
+
+        // Rows are filled in by executor_ a batch at a time. The entries and
+        // warnings of each row are then applied in state order, so the
+        // table and warnings match a serial build exactly.
+        template<typename sm_type>
+        static void build_table(const rules& rules_, const dfa& dfa_,
+            const lookahead_vector& lookaheads_, sm_type& sm_,
+            std::string& warnings_, executor& executor_,
+            std::vector<std::string>* row_warnings_, cell_vector* resolved_,
+            build_stats* stats_)
+        {
+            const grammar& grammar_ = rules_.grammar();
+            const std::size_t terminals_ = rules_.tokens_info().size();
+            const std::size_t non_terminals_ = rules_.nt_locations().size();
+            string_vector symbols_;
+            const std::size_t columns_ = terminals_ + non_terminals_;
+            // Index of the first lookahead set of each state.
+            size_t_vector la_first_(dfa_.size() + 1, 0);
+            std::vector<entry_vector> rows_(executor_.slots(),
+                entry_vector(columns_));
+            std::vector<row_result> results_;
+
+            rules_.symbols(symbols_);
+            sm_._columns = columns_;
+            sm_._terminals = terminals_;
+            sm_._rows = dfa_.size();
+            sm_.push();
+
+            if (row_warnings_)
+            {
+                row_warnings_->assign(dfa_.size(), std::string());
+            }
+
+            if (resolved_)
+            {
+                resolved_->clear();
+            }
+
+            if (stats_)
+            {
+                stats_->_precedence_resolutions = 0;
+                stats_->_table_cells = 0;
+            }
+
+            for (std::size_t index_ = 0, size_ = dfa_.size();
+                index_ < size_; ++index_)
+            {
+                const cursor_vector& closure_ = dfa_[index_]._closure;
+                std::size_t reductions_ = 0;
+
+                for (typename cursor_vector::const_iterator citer_ =
+                    closure_.begin(), cend_ = closure_.end();
+                    citer_ != cend_; ++citer_)
+                {
+                    if (grammar_[citer_->_id]._rhs._symbols.size() ==
+                        citer_->_index)
+                    {
+                        ++reductions_;
+                    }
+                }
+
+                la_first_[index_ + 1] = la_first_[index_] + reductions_;
+            }
+
+            for (std::size_t first_ = 0; first_ < dfa_.size();)
+            {
+                const std::size_t count_ =
+                    std::min(dfa_.size() - first_, batch_size());
+                table_job job_(rules_, dfa_, symbols_, lookaheads_,
+                    la_first_, first_, rows_, results_);
+
+                if (results_.size() < count_)
+                {
+                    results_.resize(count_);
+                }
+
+                executor_.run(job_, count_);
+
+                for (std::size_t r_ = 0; r_ < count_; ++r_)
+                {
+                    row_result& result_ = results_[r_];
+
+                    for (typename row_result::set_vector::const_iterator
+                        iter_ = result_._sets.begin(),
+                        end_ = result_._sets.end(); iter_ != end_; ++iter_)
+                    {
+                        sm_.set(first_ + r_, iter_->first, iter_->second);
+                    }
+
+                    warnings_ += result_._warnings;
+
+                    if (resolved_)
+                    {
+                        for (typename cell_vector::const_iterator iter_ =
+                            result_._resolved_cells.begin(),
+                            end_ = result_._resolved_cells.end();
+                            iter_ != end_; ++iter_)
+                        {
+                            resolved_->push_back(std::make_pair(la_first_
+                                [first_ + r_] + iter_->first, iter_->second));
+                        }
+                    }
+
+                    if (stats_)
+                    {
+                        stats_->_precedence_resolutions += result_._resolved;
+                        stats_->_table_cells += result_._cells;
+                    }
+
+                    if (row_warnings_)
+                    {
+                        (*row_warnings_)[first_ + r_].swap(result_._warnings);
+                    }
+                }
+
+                first_ += count_;
+            }
+        }
+
+        // The sm_.set() calls and warnings of one row, in build order.
+        struct row_result
+        {
+            typedef std::vector<std::pair<std::size_t, entry> > set_vector;
+
+            set_vector _sets;
+            std::string _warnings;
+            std::size_t _resolved;
+            // (reduction within the row, token) of each of _resolved
+            cell_vector _resolved_cells;
+            std::size_t _cells;
+
+            row_result() :
+                _resolved(0),
+                _cells(0)
+            {
+            }
+        };
+
+        struct table_job : public job
+        {
+            const rules& _rules;
+            const dfa& _dfa;
+            const string_vector& _symbols;
+            const lookahead_vector& _lookaheads;
+            const size_t_vector& _la_first;
+            const std::size_t _first;
+            // One row of entries per slot, all default between jobs.
+            std::vector<entry_vector>& _rows;
+            std::vector<row_result>& _results;
+
+            table_job(const rules& rules_, const dfa& dfa_,
+                const string_vector& symbols_,
+                const lookahead_vector& lookaheads_,
+                const size_t_vector& la_first_, const std::size_t first_,
+                std::vector<entry_vector>& rows_,
+                std::vector<row_result>& results_) :
+                _rules(rules_),
+                _dfa(dfa_),
+                _symbols(symbols_),
+                _lookaheads(lookaheads_),
+                _la_first(la_first_),
+                _first(first_),
+                _rows(rows_),
+                _results(results_)
+            {
+            }
+
+            virtual void operator()(const std::size_t index_,
+                const std::size_t slot_)
+            {
+                const std::size_t state_ = _first + index_;
+                entry_vector& row_ = _rows[slot_];
+                row_result& result_ = _results[index_];
+
+                result_._sets.clear();
+                result_._warnings.clear();
+                result_._resolved = 0;
+                result_._resolved_cells.clear();
+                result_._cells = 0;
+                build_row(_rules, _dfa[state_], _symbols,
+                    _lookaheads.begin() + _la_first[state_], row_, result_);
+
+                for (typename row_result::set_vector::const_iterator iter_ =
+                    result_._sets.begin(), end_ = result_._sets.end();
+                    iter_ != end_; ++iter_)
+                {
+                    row_[iter_->first] = entry();
+                }
+            }
+
+        private:
+            table_job& operator=(const table_job&);
+        };
+
+        static void build_row(const rules& rules_, const dfa_state& state_,
+            const string_vector& symbols_,
+            typename lookahead_vector::const_iterator la_iter_,
+            entry_vector& row_, row_result& result_)
+        {
+            const grammar& grammar_ = rules_.grammar();
+            const std::size_t start_ = rules_.start();
+            const std::size_t terminals_ = rules_.tokens_info().size();
+            std::size_t la_index_ = 0;
+
+            // shift and gotos
+            for (typename cursor_vector::const_iterator titer_ =
+                state_._transitions.begin(),
+                tend_ = state_._transitions.end();
+                titer_ != tend_; ++titer_)
+            {
+                const std::size_t id_ = titer_->_id;
+                entry lhs_ = row_[id_];
+                const entry rhs_((id_ < terminals_) ?
+                    // TERMINAL
+                    shift :
+                    // NON_TERMINAL
+                    go_to,
+                    static_cast<id_type>(titer_->_index));
+
+                if (fill_entry(rules_, state_._closure, symbols_,
+                    lhs_, id_, rhs_, result_))
+                {
+                    row_[id_] = lhs_;
+                    result_._sets.push_back(std::make_pair(id_, lhs_));
+                }
+            }
+
+            // reductions
+            for (typename cursor_vector::const_iterator citer_ =
+                state_._closure.begin(),
+                cend_ = state_._closure.end(); citer_ != cend_; ++citer_)
+            {
+                const production& production_ = grammar_[citer_->_id];
+
+                if (production_._rhs._symbols.size() == citer_->_index)
+                {
+                    // config is reduction
+                    const std::size_t reduction_ = la_index_++;
+                    const bit_vector& follow_set_ = *la_iter_++;
+
+                    for (std::size_t id_ = follow_set_.find_first(),
+                        size_ = follow_set_.size(); id_ < size_;
+                        id_ = follow_set_.find_next(id_ + 1))
+                    {
+                        entry lhs_ = row_[id_];
+                        const entry rhs_(production_._lhs == start_ ?
+                            accept :
+                            reduce,
+                            static_cast<id_type>(production_._index));
+                        const std::size_t resolved_ = result_._resolved;
+
+                        if (fill_entry(rules_, state_._closure, symbols_,
+                            lhs_, id_, rhs_, result_))
+                        {
+                            row_[id_] = lhs_;
+                            result_._sets.push_back(std::make_pair(id_, lhs_));
+                        }
+
+                        if (result_._resolved != resolved_)
+                        {
+                            result_._resolved_cells.push_back
+                                (std::make_pair(reduction_, id_));
+                        }
+                    }
+                }
+            }
+        }
+
+        // Number of DFA states handed to an executor at once.
+        static std::size_t batch_size()
+        {
+            return 1024;
+        }
+
+        // If you get an error here then your id_type is too small for the
+        // table. basic_packed_state_machine picks the narrowest cell
+        // width that fits automatically.
+        static void check_id_type(const rules& rules_,
+            const std::size_t rows_)
+        {
+            typedef typename sm::id_type sm_id_type;
+            const std::size_t columns_ = rules_.tokens_info().size() +
+                rules_.nt_locations().size();
+            const std::size_t max_ = std::max(std::max(columns_,
+                rows_), rules_.grammar().size()) - 1;
+
+            // ~0 is reserved as npos.
+            if (max_ >= static_cast<std::size_t>(static_cast<id_type>(~0)) ||
+                max_ >= static_cast<std::size_t>(static_cast<sm_id_type>(~0)))
+            {
+                std::ostringstream ss_;
+
+                ss_ << "id_type is too small for the state machine (" <<
+                    max_ + 1 << " ids required).";
+                throw runtime_error(ss_.str());
+            }
+        }
+
+        // A row whose only action is a single reduction (bison's
+        // consistent state) reduces without consulting the lookahead.
+        // The $ entry is kept so that at(state_) still says whether the
+        // input may end there.
+        template<typename sm_type>
+        static void build_default_reductions(sm_type& sm_)
+        {
+            typedef typename sm_type::id_type sm_id_type;
+
+            sm_._default_reductions.assign(sm_._rows,
+                static_cast<sm_id_type>(~0));
+
+            for (std::size_t index_ = 0; index_ < sm_._rows; ++index_)
+            {
+                std::size_t rule_ = npos();
+
+                for (std::size_t id_ = 0; id_ < sm_._columns; ++id_)
+                {
+                    const entry entry_ = sm_.at(index_, id_);
+
+                    if (entry_.action == error &&
+                        entry_.param == syntax_error)
+                        continue;
+
+                    if (entry_.action != reduce ||
+                        (rule_ != npos() && rule_ != entry_.param))
+                    {
+                        rule_ = npos();
+                        break;
+                    }
+
+                    rule_ = entry_.param;
+                }
+
+                if (rule_ != npos())
+                {
+                    const entry eoi_ = sm_.at(index_);
+
+                    sm_._default_reductions[index_] =
+                        static_cast<sm_id_type>(rule_);
+                    sm_.clear_row(index_);
+
+                    if (eoi_.action != error)
+                        sm_.set(index_, 0, eoi_);
+                }
+            }
+        }
+
+        // A unit production (A -> B) can be bypassed if its reduction does
+        // not need to be reported.
+        static bool bypassable(const rules& rules_,
+            const production& production_)
+        {
+            const typename rules::captures_deque& captures_ =
+                rules_.captures();
+
+            return !production_._keep &&
+                production_._rhs._symbols.size() == 1 &&
+                production_._rhs._symbols.front()._type ==
+                    symbol::NON_TERMINAL &&
+                (production_._index >= captures_.size() ||
+                captures_[production_._index].second.empty());
+        }
+
+        // Replace each goto(s, B) that leads to a reduction by a bypassable
+        // A -> B with a state that acts as if the reduction and goto(s, A)
+        // had already happened, so that chains of unit productions collapse
+        // into a single goto. Such states are merged from the rows involved
+        // and appended to the table; rows no longer reachable are removed.
+        static void eliminate_units(const rules& rules_, unit_sm& sm_)
+        {
+            const grammar& grammar_ = rules_.grammar();
+            char_vector units_(grammar_.size(), 0);
+            merge_map map_;
+
+            for (std::size_t index_ = 0, size_ = grammar_.size();
+                index_ < size_; ++index_)
+            {
+                units_[index_] = bypassable(rules_, grammar_[index_]);
+            }
+
+            // Merged rows are appended to the table. They are not revisited:
+            // bypassing their gotos could merge rows from merged rows
+            // without end. Their gotos still lead to correct (if unbypassed)
+            // states.
+            for (std::size_t state_ = 0, rows_ = sm_._table.size();
+                state_ < rows_; ++state_)
+            {
+                const pair_vector row_ = sm_._table[state_];
+
+                for (typename pair_vector::const_iterator iter_ =
+                    row_.begin(), end_ = row_.end(); iter_ != end_; ++iter_)
+                {
+                    if (iter_->_entry.action != go_to) continue;
+
+                    const std::size_t target_ = bypass(rules_, units_, map_,
+                        sm_, state_, iter_->_id, 0);
+
+                    if (target_ != iter_->_entry.param)
+                        sm_.set(state_, iter_->_id, entry(go_to,
+                            static_cast<typename sm::id_type>(target_)));
+                }
+            }
+
+            remove_unreachable(sm_);
+        }
+
+        // Returns the state to go to from state_ on non-terminal id_.
+        static std::size_t bypass(const rules& rules_,
+            const char_vector& units_, merge_map& map_, unit_sm& sm_,
+            const std::size_t state_, const std::size_t id_,
+            const std::size_t depth_)
+        {
+            const grammar& grammar_ = rules_.grammar();
+            const std::size_t target_ = sm_.at(state_, id_).param;
+            // target_ followed by (lhs id, bypassed goto) pairs.
+            size_t_vector key_(1, target_);
+            pair_vector row_;
+
+            // Cyclic unit productions cannot be bypassed.
+            if (depth_ > sm_._columns) return target_;
+
+            for (std::size_t index_ = 0, size_ = sm_._table[target_].size();
+                index_ < size_; ++index_)
+            {
+                const entry& entry_ = sm_._table[target_][index_]._entry;
+
+                if (entry_.action == reduce && units_[entry_.param])
+                {
+                    const std::size_t lhs_ = sm_._terminals +
+                        grammar_[entry_.param]._lhs;
+
+                    if (find_lhs(key_, lhs_) == key_.size())
+                    {
+                        key_.push_back(lhs_);
+                        key_.push_back(npos());
+                    }
+                }
+            }
+
+            if (key_.size() == 1) return target_;
+
+            for (std::size_t index_ = 1; index_ < key_.size(); index_ += 2)
+            {
+                if (sm_.at(state_, key_[index_]).action != go_to)
+                    return target_;
+
+                key_[index_ + 1] = bypass(rules_, units_, map_, sm_, state_,
+                    key_[index_], depth_ + 1);
+            }
+
+            typename merge_map::const_iterator map_iter_ = map_.find(key_);
+
+            if (map_iter_ != map_.end()) return map_iter_->second;
+
+            // Lookaheads that reduced A -> B take the action of goto(s, A).
+            for (typename pair_vector::const_iterator iter_ =
+                sm_._table[target_].begin(), end_ = sm_._table[target_].end();
+                iter_ != end_; ++iter_)
+            {
+                const entry& entry_ = iter_->_entry;
+
+                if (entry_.action == reduce && units_[entry_.param])
+                {
+                    const std::size_t lhs_ = sm_._terminals +
+                        grammar_[entry_.param]._lhs;
+                    const std::size_t index_ = find_lhs(key_, lhs_);
+                    const entry new_entry_ =
+                        sm_.at(key_[index_ + 1], iter_->_id);
+
+                    if (new_entry_.action != error ||
+                        new_entry_.param != syntax_error)
+                        row_.push_back(state_pair(iter_->_id, new_entry_));
+                }
+                else
+                    row_.push_back(*iter_);
+            }
+
+            // Reductions made after those actions go to from the same row.
+            for (std::size_t index_ = 2; index_ < key_.size(); index_ += 2)
+            {
+                const pair_vector& gotos_ = sm_._table[key_[index_]];
+
+                for (typename pair_vector::const_iterator iter_ =
+                    gotos_.begin(), end_ = gotos_.end(); iter_ != end_;
+                    ++iter_)
+                {
+                    if (iter_->_entry.action != go_to) continue;
+
+                    typename pair_vector::const_iterator row_iter_ =
+                        row_.begin();
+
+                    for (; row_iter_ != row_.end(); ++row_iter_)
+                    {
+                        if (row_iter_->_id == iter_->_id) break;
+                    }
+
+                    if (row_iter_ == row_.end())
+                        row_.push_back(*iter_);
+                    else if (!(row_iter_->_entry == iter_->_entry))
+                        return target_;
+                }
+            }
+
+            map_[key_] = sm_._table.size();
+            sm_._table.push_back(pair_vector());
+            sm_._table.back().swap(row_);
+            sm_._rows = sm_._table.size();
+            return sm_._rows - 1;
+        }
+
+        static std::size_t find_lhs(const size_t_vector& key_,
+            const std::size_t lhs_)
+        {
+            std::size_t index_ = 1;
+
+            for (; index_ < key_.size(); index_ += 2)
+            {
+                if (key_[index_] == lhs_) break;
+            }
+
+            return index_ < key_.size() ? index_ : key_.size();
+        }
+
+        static void remove_unreachable(unit_sm& sm_)
+        {
+            size_t_vector new_index_(sm_._rows, npos());
+            size_t_vector stack_(1, 0);
+            typename unit_sm::table table_;
+
+            new_index_[0] = 0;
+
+            while (!stack_.empty())
+            {
+                const pair_vector& row_ = sm_._table[stack_.back()];
+
+                stack_.pop_back();
+
+                for (typename pair_vector::const_iterator iter_ =
+                    row_.begin(), end_ = row_.end(); iter_ != end_; ++iter_)
+                {
+                    const entry& entry_ = iter_->_entry;
+
+                    if ((entry_.action == shift || entry_.action == go_to) &&
+                        new_index_[entry_.param] == npos())
+                    {
+                        new_index_[entry_.param] = 0;
+                        stack_.push_back(entry_.param);
+                    }
+                }
+            }
+
+            // Keep the original order of the remaining rows.
+            for (std::size_t state_ = 0; state_ < sm_._rows; ++state_)
+            {
+                if (new_index_[state_] == npos()) continue;
+
+                new_index_[state_] = table_.size();
+                table_.push_back(pair_vector());
+                table_.back().swap(sm_._table[state_]);
+            }
+
+            for (typename unit_sm::table::iterator iter_ = table_.begin(),
+                end_ = table_.end(); iter_ != end_; ++iter_)
+            {
+                for (typename pair_vector::iterator row_iter_ =
+                    iter_->begin(), row_end_ = iter_->end();
+                    row_iter_ != row_end_; ++row_iter_)
+                {
+                    entry& entry_ = row_iter_->_entry;
+
+                    if (entry_.action == shift || entry_.action == go_to)
+                        entry_.param = static_cast<typename sm::id_type>
+                            (new_index_[entry_.param]);
+                }
+            }
+
+            sm_._table.swap(table_);
+            sm_._rows = sm_._table.size();
+        }
+
+        template<typename sm_type>
+        static void copy_table(const unit_sm& from_, sm_type& to_)
+        {
+            to_._columns = from_._columns;
+            to_._terminals = from_._terminals;
+            to_._rows = from_._rows;
+            to_.push();
+
+            for (std::size_t state_ = 0; state_ < from_._rows; ++state_)
+            {
+                const pair_vector& row_ = from_._table[state_];
+
+                for (typename pair_vector::const_iterator iter_ =
+                    row_.begin(), end_ = row_.end(); iter_ != end_; ++iter_)
+                {
+                    to_.set(state_, iter_->_id, iter_->_entry);
+                }
+            }
+        }
+
+        // Nothing to do if the table was built in place.
+        static void assign_table(sm&, sm&)
+        {
+        }
+
+        template<typename sm_type>
+        static void assign_table(const unit_sm& table_, sm_type& sm_)
+        {
+            sm_.assign(table_);
+        }
+
+        static void copy_rules(const rules& rules_, sm& sm_)
+        {
+            const grammar& grammar_ = rules_.grammar();
+            const std::size_t terminals_ = rules_.tokens_info().size();
+            typename grammar::const_iterator iter_ = grammar_.begin();
+            typename grammar::const_iterator end_ = grammar_.end();
+
+            for (; iter_ != end_; ++iter_)
+            {
+                const production& production_ = *iter_;
+                typename symbol_vector::const_iterator rhs_iter_ =
+                    production_._rhs._symbols.begin();
+                typename symbol_vector::const_iterator rhs_end_ =
+                    production_._rhs._symbols.end();
+
+                sm_._rules.push_back(typename sm::id_type_vector_pair());
+
+                typename sm::id_type_vector_pair& pair_ = sm_._rules.back();
+
+                pair_._lhs = static_cast<id_type>(terminals_ +
+                    production_._lhs);
+
+                for (; rhs_iter_ != rhs_end_; ++rhs_iter_)
+                {
+                    const symbol& symbol_ = *rhs_iter_;
+
+                    if (symbol_._type == symbol::TERMINAL)
+                    {
+                        pair_._rhs.push_back(static_cast
+                            <id_type>(symbol_._id));
+                    }
+                    else
+                    {
+                        pair_._rhs.push_back(static_cast
+                            <id_type>(terminals_ + symbol_._id));
+                    }
+                }
+            }
+
+            sm_.flatten_rules();
+        }
+
+        // Helper functions:
+
+        // Pushes each non-terminal's set along its edges until nothing
+        // changes, revisiting only the targets that actually grew.
+        static void propagate(std::vector<size_t_vector>& edges_,
+            nt_info_vector& nt_info_, bit_vector nt_info::* set_)
+        {
+            const std::size_t size_ = nt_info_.size();
+            size_t_vector worklist_;
+            std::vector<char> queued_(size_, 0);
+
+            for (std::size_t id_ = 0; id_ < size_; ++id_)
+            {
+                size_t_vector& targets_ = edges_[id_];
+
+                std::sort(targets_.begin(), targets_.end());
+                targets_.erase(std::unique(targets_.begin(), targets_.end()),
+                    targets_.end());
+
+                if (!targets_.empty())
+                {
+                    worklist_.push_back(id_);
+                    queued_[id_] = 1;
+                }
+            }
+
+            while (!worklist_.empty())
+            {
+                const std::size_t id_ = worklist_.back();
+                const size_t_vector& targets_ = edges_[id_];
+
+                worklist_.pop_back();
+                queued_[id_] = 0;
+
+                for (typename size_t_vector::const_iterator iter_ =
+                    targets_.begin(), end_ = targets_.end();
+                    iter_ != end_; ++iter_)
+                {
+                    if (set_union(nt_info_[*iter_].*set_,
+                        nt_info_[id_].*set_) && !queued_[*iter_] &&
+                        !edges_[*iter_].empty())
+                    {
+                        worklist_.push_back(*iter_);
+                        queued_[*iter_] = 1;
                     }
                 }
             }
         }
 
-        static std::size_t add_dfa_state(dfa& dfa_, hash_map& hash_map_,
-            cursor_vector& basis_)
+        // Nullable flag of every non-terminal of the original grammar.
+        static void build_nullable(const rules& rules_, char_vector& nullable_)
         {
-            size_t_vector& states_ = hash_map_[hash_set(basis_)];
-            std::size_t index_ = npos();
+            const grammar& grammar_ = rules_.grammar();
+            // Number of rhs symbols not yet known to be nullable.
+            size_t_vector pending_(grammar_.size(), 0);
+            std::vector<size_t_vector> users_(rules_.nt_locations().size());
+            size_t_vector worklist_;
+
+            nullable_.assign(users_.size(), 0);
+
+            for (std::size_t p_ = 0, size_ = grammar_.size(); p_ < size_; ++p_)
+            {
+                const symbol_vector& rhs_ = grammar_[p_]._rhs._symbols;
+                typename symbol_vector::const_iterator iter_ = rhs_.begin();
+                typename symbol_vector::const_iterator end_ = rhs_.end();
+
+                for (; iter_ != end_; ++iter_)
+                {
+                    if (iter_->_type == symbol::TERMINAL) break;
+                }
+
+                if (iter_ != end_) continue;
+
+                pending_[p_] = rhs_.size();
+
+                for (iter_ = rhs_.begin(); iter_ != end_; ++iter_)
+                {
+                    users_[iter_->_id].push_back(p_);
+                }
+
+                if (rhs_.empty() && !nullable_[grammar_[p_]._lhs])
+                {
+                    nullable_[grammar_[p_]._lhs] = 1;
+                    worklist_.push_back(grammar_[p_]._lhs);
+                }
+            }
 
-            if (!states_.empty())
+            while (!worklist_.empty())
             {
+                const size_t_vector& users_of_ = users_[worklist_.back()];
+
+                worklist_.pop_back();
+
                 for (typename size_t_vector::const_iterator iter_ =
-                    states_.begin(), end_ = states_.end(); iter_ != end_;
-                    ++iter_)
+                    users_of_.begin(), end_ = users_of_.end();
+                    iter_ != end_; ++iter_)
                 {
-                    dfa_state& state_ = dfa_[*iter_];
+                    const std::size_t lhs_ = grammar_[*iter_]._lhs;
 
-                    if (state_._basis == basis_)
+                    if (--pending_[*iter_] == 0 && !nullable_[lhs_])
                     {
-                        index_ = *iter_;
-                        break;
+                        nullable_[lhs_] = 1;
+                        worklist_.push_back(lhs_);
+                    }
+                }
+            }
+        }
+
+        static std::size_t find_goto(const dfa_state& state_,
+            const std::size_t id_)
+        {
+            for (typename cursor_vector::const_iterator iter_ =
+                state_._transitions.begin(), end_ = state_._transitions.end();
+                iter_ != end_; ++iter_)
+            {
+                if (iter_->_id == id_) return iter_->_index;
+            }
+
+            return npos();
+        }
+
+        // DeRemer and Pennello's digraph(): on return each set holds its
+        // initial contents plus the sets of everything reachable from it
+        // through relation_. Members of a cycle end up with equal sets.
+        // The depth first traversal keeps its own stack so that deep
+        // relations cannot overflow the call stack.
+        static void digraph(const std::vector<size_t_vector>& relation_,
+            lookahead_vector& sets_)
+        {
+            const std::size_t size_ = relation_.size();
+            // 0 is unvisited, npos() is finished, otherwise stack depth.
+            size_t_vector depth_(size_, 0);
+            size_t_vector stack_;
+            // (node, next edge to follow)
+            std::vector<std::pair<std::size_t, std::size_t> > calls_;
+
+            for (std::size_t root_ = 0; root_ < size_; ++root_)
+            {
+                if (depth_[root_] != 0) continue;
+
+                stack_.push_back(root_);
+                depth_[root_] = stack_.size();
+                calls_.push_back(std::make_pair(root_,
+                    static_cast<std::size_t>(0)));
+
+                while (!calls_.empty())
+                {
+                    const std::size_t x_ = calls_.back().first;
+                    const size_t_vector& edges_ = relation_[x_];
+
+                    if (calls_.back().second < edges_.size())
+                    {
+                        const std::size_t y_ = edges_[calls_.back().second++];
+
+                        if (depth_[y_] == 0)
+                        {
+                            stack_.push_back(y_);
+                            depth_[y_] = stack_.size();
+                            calls_.push_back(std::make_pair(y_,
+                                static_cast<std::size_t>(0)));
+                        }
+                        else
+                        {
+                            depth_[x_] = std::min(depth_[x_], depth_[y_]);
+                            set_union(sets_[x_], sets_[y_]);
+                        }
+
+                        continue;
+                    }
+
+                    calls_.pop_back();
+
+                    if (stack_[depth_[x_] - 1] == x_)
+                    {
+                        // x_ is the root of a strongly connected component.
+                        for (;;)
+                        {
+                            const std::size_t top_ = stack_.back();
+
+                            stack_.pop_back();
+                            depth_[top_] = npos();
+
+                            if (top_ == x_) break;
+
+                            sets_[top_] = sets_[x_];
+                        }
+                    }
+
+                    if (!calls_.empty())
+                    {
+                        const std::size_t parent_ = calls_.back().first;
+
+                        depth_[parent_] = std::min(depth_[parent_],
+                            depth_[x_]);
+                        set_union(sets_[parent_], sets_[x_]);
+                    }
+                }
+            }
+        }
+
+        // Add a new element to the set. Return true if the element was added
+        // and false if it was already there.
+        static bool set_add(bit_vector& s_, const std::size_t e_)
+        {
+            assert(e_ < s_.size());
+            return s_.set(e_);
+        }
+
+        // Add every element of rhs_ to lhs_. Return true if lhs_ changes.
+        static bool set_union(bit_vector& lhs_, const bit_vector& rhs_)
+        {
+            return lhs_.set_union(rhs_);
+        }
+
+        // Every distinct kernel is stored once, back to back in a single
+        // arena, and found again through an open addressing hash table.
+        // Kernel n belongs to DFA state n.
+        struct kernel_table
+        {
+            cursor_vector _arena;
+            // Kernel n occupies [_offsets[n], _offsets[n + 1]) in _arena.
+            size_t_vector _offsets;
+            size_t_vector _hashes;
+            // Kernel indexes, or npos() for an empty slot.
+            size_t_vector _slots;
+
+            kernel_table() :
+                _offsets(1, 0),
+                _slots(64, npos())
+            {
+            }
+
+            const cursor* begin(const std::size_t index_) const
+            {
+                return &_arena.front() + _offsets[index_];
+            }
+
+            const cursor* end(const std::size_t index_) const
+            {
+                return &_arena.front() + _offsets[index_ + 1];
+            }
+
+            // Sets index_ to the kernel matching [first_, last_), adding it
+            // if it is new. Returns true if the kernel was added.
+            bool insert(const cursor* first_, const cursor* last_,
+                std::size_t& index_)
+            {
+                const std::size_t hash_ = hash(first_, last_);
+                const std::size_t mask_ = _slots.size() - 1;
+                const std::size_t size_ = last_ - first_;
+                std::size_t slot_ = hash_ & mask_;
+
+                for (; _slots[slot_] != npos(); slot_ = (slot_ + 1) & mask_)
+                {
+                    index_ = _slots[slot_];
+
+                    if (_hashes[index_] == hash_ &&
+                        _offsets[index_ + 1] - _offsets[index_] == size_ &&
+                        std::equal(first_, last_, begin(index_)))
+                    {
+                        return false;
+                    }
+                }
+
+                index_ = _hashes.size();
+                _slots[slot_] = index_;
+                _hashes.push_back(hash_);
+                _arena.insert(_arena.end(), first_, last_);
+                _offsets.push_back(_arena.size());
+
+                // Keep the load factor at or below one half.
+                if (_hashes.size() * 2 > _slots.size())
+                {
+                    rehash();
+                }
+
+                return true;
+            }
+
+            void rehash()
+            {
+                const std::size_t mask_ = _slots.size() * 2 - 1;
+
+                _slots.assign(mask_ + 1, npos());
+
+                for (std::size_t idx_ = 0, size_ = _hashes.size();
+                    idx_ < size_; ++idx_)
+                {
+                    std::size_t slot_ = _hashes[idx_] & mask_;
+
+                    while (_slots[slot_] != npos())
+                    {
+                        slot_ = (slot_ + 1) & mask_;
+                    }
+
+                    _slots[slot_] = idx_;
+                }
+            }
+
+            static std::size_t hash(const cursor* first_,
+                const cursor* last_)
+            {
+                std::size_t hash_ = static_cast<std::size_t>(last_ - first_);
+
+                for (; first_ != last_; ++first_)
+                {
+                    combine(hash_, first_->_id);
+                    combine(hash_, first_->_index);
+                }
+
+                return hash_;
+            }
+
+            static void combine(std::size_t& hash_, const std::size_t value_)
+            {
+                hash_ ^= value_ + 0x9e3779b9 + (hash_ << 6) + (hash_ >> 2);
+            }
+        };
+
+        // The LR(0) automaton, once rules_ has been validated.
+        static void build_states(const rules& rules_, dfa& dfa_,
+            executor& executor_)
+        {
+            const std::size_t start_ = rules_.start();
+            kernel_table kernels_;
+            std::vector<size_t_vector> productions_;
+            std::vector<dfa_scratch> scratch_(executor_.slots(),
+                dfa_scratch(rules_));
+            std::vector<goto_sets> gotos_;
+            cursor basis_;
+
+            // Only applies if build_dfa() has been called directly
+            // from client code (i.e. build() will have already called
+            // validate() in the normal case).
+            if (start_ == npos())
+            {
+                basis_ = cursor(0, 0);
+            }
+            else
+            {
+                const std::size_t index_ = rules_.nt_locations()[start_].
+                    _first_production;
+
+                basis_ = cursor(index_, 0);
+            }
+
+            std::size_t index_ = npos();
+
+            nt_productions(rules_, productions_);
+            kernels_.insert(&basis_, &basis_ + 1, index_);
+            dfa_.push_back(dfa_state());
+
+            for (std::size_t first_ = 0; first_ < dfa_.size();)
+            {
+                const std::size_t count_ =
+                    std::min(dfa_.size() - first_, batch_size());
+                dfa_job job_(rules_, productions_, kernels_, dfa_, first_,
+                    scratch_, gotos_);
+
+                if (gotos_.size() < count_)
+                {
+                    gotos_.resize(count_);
+                }
+
+                executor_.run(job_, count_);
+
+                for (std::size_t s_ = 0; s_ < count_; ++s_)
+                {
+                    dfa_state& state_ = dfa_[first_ + s_];
+                    goto_sets& sets_ = gotos_[s_];
+                    std::size_t begin_ = 0;
+
+                    state_._transitions.reserve(sets_._symbols.size());
+
+                    for (std::size_t i_ = 0, size_ = sets_._symbols.size();
+                        i_ < size_; ++i_)
+                    {
+                        const cursor* items_ = &sets_._items.front();
+
+                        if (kernels_.insert(items_ + begin_,
+                            items_ + sets_._ends[i_], index_))
+                        {
+                            dfa_.push_back(dfa_state());
+                        }
+
+                        state_._transitions.push_back
+                            (cursor(sets_._symbols[i_], index_));
+                        begin_ = sets_._ends[i_];
+                    }
+                }
+
+                first_ += count_;
+            }
+        }
+
+        // Initial items of each non-terminal, in _next_lhs order.
+        static void nt_productions(const rules& rules_,
+            std::vector<size_t_vector>& productions_)
+        {
+            const typename rules::nt_location_vector& nt_locations_ =
+                rules_.nt_locations();
+            const grammar& grammar_ = rules_.grammar();
+
+            productions_.assign(nt_locations_.size(), size_t_vector());
+
+            for (std::size_t nt_ = 0, size_ = nt_locations_.size();
+                nt_ < size_; ++nt_)
+            {
+                for (std::size_t rule_ = nt_locations_[nt_]._first_production;
+                    rule_ != npos(); rule_ = grammar_[rule_]._next_lhs)
+                {
+                    productions_[nt_].push_back(rule_);
+                }
+            }
+        }
+
+        // Scratch space for expanding one DFA state at a time.
+        // Each executor slot has its own.
+        struct dfa_scratch
+        {
+            // A stamp equal to _generation has already been seen while
+            // expanding the current state.
+            std::size_t _generation;
+            size_t_vector _nt_stamps;
+            size_t_vector _prod_stamps;
+            size_t_vector _sym_stamps;
+            // Item set of each symbol and of each closure item.
+            size_t_vector _sym_index;
+            size_t_vector _item_sym;
+
+            dfa_scratch(const rules& rules_) :
+                _generation(0),
+                _nt_stamps(rules_.nt_locations().size(), 0),
+                _prod_stamps(rules_.grammar().size(), 0),
+                _sym_stamps(rules_.tokens_info().size() +
+                    rules_.nt_locations().size(), 0),
+                _sym_index(_sym_stamps.size(), 0)
+            {
+            }
+        };
+
+        // The goto item sets of one state. The (sorted) kernel reached
+        // over _symbols[i] ends at _ends[i] in _items.
+        struct goto_sets
+        {
+            size_t_vector _symbols;
+            size_t_vector _ends;
+            cursor_vector _items;
+        };
+
+        struct dfa_job : public job
+        {
+            const rules& _rules;
+            const std::vector<size_t_vector>& _productions;
+            const kernel_table& _kernels;
+            dfa& _dfa;
+            const std::size_t _first;
+            std::vector<dfa_scratch>& _scratch;
+            std::vector<goto_sets>& _gotos;
+
+            dfa_job(const rules& rules_,
+                const std::vector<size_t_vector>& productions_,
+                const kernel_table& kernels_, dfa& dfa_,
+                const std::size_t first_,
+                std::vector<dfa_scratch>& scratch_,
+                std::vector<goto_sets>& gotos_) :
+                _rules(rules_),
+                _productions(productions_),
+                _kernels(kernels_),
+                _dfa(dfa_),
+                _first(first_),
+                _scratch(scratch_),
+                _gotos(gotos_)
+            {
+            }
+
+            virtual void operator()(const std::size_t index_,
+                const std::size_t slot_)
+            {
+                const std::size_t state_ = _first + index_;
+
+                _dfa[state_]._closure.assign(_kernels.begin(state_),
+                    _kernels.end(state_));
+                expand_state(_rules, _productions, _scratch[slot_],
+                    _dfa[state_], _gotos[index_]);
+            }
+
+        private:
+            dfa_job& operator=(const dfa_job&);
+        };
+
+        // On entry state_._closure holds the kernel.
+        static void expand_state(const rules& rules_,
+            const std::vector<size_t_vector>& productions_,
+            dfa_scratch& scratch_, dfa_state& state_, goto_sets& gotos_)
+        {
+            const grammar& grammar_ = rules_.grammar();
+            const std::size_t terminals_ = rules_.tokens_info().size();
+            const std::size_t generation_ = ++scratch_._generation;
+            size_t_vector& ends_ = gotos_._ends;
+
+            closure(grammar_, productions_, scratch_, state_);
+            gotos_._symbols.clear();
+            ends_.clear();
+            scratch_._item_sym.clear();
+
+            // Count the items moving over each symbol.
+            for (typename cursor_vector::const_iterator iter_ =
+                state_._closure.begin(), end_ = state_._closure.end();
+                iter_ != end_; ++iter_)
+            {
+                const production& p_ = grammar_[iter_->_id];
+
+                if (iter_->_index < p_._rhs._symbols.size())
+                {
+                    const symbol& symbol_ = p_._rhs._symbols[iter_->_index];
+                    const std::size_t id_ =
+                        symbol_._type == symbol::TERMINAL ?
+                        symbol_._id : terminals_ + symbol_._id;
+
+                    if (scratch_._sym_stamps[id_] != generation_)
+                    {
+                        scratch_._sym_stamps[id_] = generation_;
+                        scratch_._sym_index[id_] = gotos_._symbols.size();
+                        gotos_._symbols.push_back(id_);
+                        ends_.push_back(0);
                     }
+
+                    ++ends_[scratch_._sym_index[id_]];
+                    scratch_._item_sym.push_back(scratch_._sym_index[id_]);
+                }
+                else
+                {
+                    scratch_._item_sym.push_back(npos());
                 }
             }
 
-            if (states_.empty() || index_ == npos())
+            // Turn the counts into the start of each item set.
+            std::size_t total_ = 0;
+
+            for (typename size_t_vector::iterator iter_ = ends_.begin(),
+                end_ = ends_.end(); iter_ != end_; ++iter_)
+            {
+                const std::size_t count_ = *iter_;
+
+                *iter_ = total_;
+                total_ += count_;
+            }
+
+            gotos_._items.resize(total_);
+
+            // Closure items are unique, so advancing the dot over
+            // each one yields unique items in each item set.
+            // Afterwards ends_[i] marks the end of item set i.
+            for (std::size_t c_ = 0, size_ = state_._closure.size();
+                c_ < size_; ++c_)
             {
-                index_ = dfa_.size();
-                states_.push_back(index_);
-                dfa_.push_back(dfa_state());
-                dfa_.back()._basis.swap(basis_);
+                const std::size_t set_ = scratch_._item_sym[c_];
+
+                if (set_ != npos())
+                {
+                    const cursor& pair_ = state_._closure[c_];
+
+                    gotos_._items[ends_[set_]++] =
+                        cursor(pair_._id, pair_._index + 1);
+                }
             }
 
-            return index_;
+            for (std::size_t i_ = 0, begin_ = 0, size_ = ends_.size();
+                i_ < size_; begin_ = ends_[i_++])
+            {
+                std::sort(gotos_._items.begin() + begin_,
+                    gotos_._items.begin() + ends_[i_]);
+            }
         }
 
-        static std::size_t hash_set(cursor_vector& vec_)
+        // Each non-terminal is expanded at most once per state, so the
+        // closure is built in time linear in its size. Items are appended
+        // in the same breadth first order as a naive closure.
+        static void closure(const grammar& grammar_,
+            const std::vector<size_t_vector>& productions_,
+            dfa_scratch& scratch_, dfa_state& state_)
         {
-            std::size_t hash_ = 0;
+            const std::size_t generation_ = scratch_._generation;
 
             for (typename cursor_vector::const_iterator iter_ =
-                vec_.begin(), end_ = vec_.end(); iter_ != end_; ++iter_)
+                state_._closure.begin(), end_ = state_._closure.end();
+                iter_ != end_; ++iter_)
             {
-                hash_ *= 571;
-                hash_ += iter_->_id * 37 + iter_->_index;
+                if (iter_->_index == 0)
+                {
+                    scratch_._prod_stamps[iter_->_id] = generation_;
+                }
             }
 
-            return hash_;
+            for (std::size_t c_ = 0; c_ < state_._closure.size(); ++c_)
+            {
+                const cursor pair_ = state_._closure[c_];
+                const production& p_ = grammar_[pair_._id];
+
+                if (pair_._index < p_._rhs._symbols.size())
+                {
+                    // SHIFT
+                    const symbol& symbol_ = p_._rhs._symbols[pair_._index];
+
+                    if (symbol_._type == symbol::NON_TERMINAL &&
+                        scratch_._nt_stamps[symbol_._id] != generation_)
+                    {
+                        const size_t_vector& nt_productions_ =
+                            productions_[symbol_._id];
+
+                        scratch_._nt_stamps[symbol_._id] = generation_;
+
+                        for (typename size_t_vector::const_iterator iter_ =
+                            nt_productions_.begin(),
+                            end_ = nt_productions_.end();
+                            iter_ != end_; ++iter_)
+                        {
+                            if (scratch_._prod_stamps[*iter_] != generation_)
+                            {
+                                scratch_._prod_stamps[*iter_] = generation_;
+                                state_._closure.push_back(cursor(*iter_, 0));
+                            }
+                        }
+                    }
+                }
+            }
         }
 
         static bool fill_entry(const rules& rules_,
             const cursor_vector& config_, const string_vector& symbols_,
             entry& lhs_, const std::size_t id_, const entry& rhs_,
-            std::string& warnings_)
+            row_result& result_)
         {
+            std::string& warnings_ = result_._warnings;
             bool modified_ = false;
             const grammar& grammar_ = rules_.grammar();
             const token_info_vector& tokens_info_ = rules_.tokens_info();
@@ -798,6 +2691,7 @@ namespace parsertl
                     // No conflict
                     lhs_ = rhs_;
                     modified_ = true;
+                    ++result_._cells;
                 }
                 else
                 {
@@ -835,6 +2729,13 @@ namespace parsertl
 
                 if (lhs_.action == shift && rhs_.action == reduce)
                 {
+                    if (lhs_prec_ != 0 && rhs_prec_ != 0 &&
+                        (lhs_prec_ != rhs_prec_ ||
+                        lhs_assoc_ != rules::precedence_assoc))
+                    {
+                        ++result_._resolved;
+                    }
+
                     if (lhs_prec_ == 0 || rhs_prec_ == 0)
                     {
                         // Favour shift (leave lhs as it is).
@@ -1002,9 +2903,20 @@ namespace parsertl
     typedef basic_generator<rules, state_machine> generator;
     typedef basic_generator<rules, uncompressed_state_machine>
         uncompressed_generator;
+    typedef basic_generator<rules, classed_state_machine> classed_generator;
+    typedef basic_generator<rules, csr_state_machine> csr_generator;
+    typedef basic_generator<rules, comb_state_machine> comb_generator;
+    typedef basic_generator<rules, packed_state_machine> packed_generator;
+    typedef basic_generator<rules, split_state_machine> split_generator;
     typedef basic_generator<wrules, state_machine> wgenerator;
     typedef basic_generator<wrules, uncompressed_state_machine>
         wuncompressed_generator;
+    typedef basic_generator<wrules, classed_state_machine>
+        wclassed_generator;
+    typedef basic_generator<wrules, csr_state_machine> wcsr_generator;
+    typedef basic_generator<wrules, comb_state_machine> wcomb_generator;
+    typedef basic_generator<wrules, packed_state_machine> wpacked_generator;
+    typedef basic_generator<wrules, split_state_machine> wsplit_generator;
 }
 
 #endif
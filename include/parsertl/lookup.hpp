@@ -12,9 +12,9 @@
 namespace parsertl
 {
     // parse sequence but do not keep track of productions
-    template<typename lexer_iterator, typename sm_type>
+    template<typename lexer_iterator, typename sm_type, typename stack_type>
     void lookup(lexer_iterator& iter_, const sm_type& sm_,
-        basic_match_results<sm_type>& results_)
+        basic_match_results<sm_type, stack_type>& results_)
     {
         switch (results_.entry.action)
         {
@@ -31,7 +31,8 @@ namespace parsertl
                 results_.entry.action = error;
                 results_.entry.param = unknown_token;
             }
-            else
+            else if (!sm_.default_reduction(results_.entry.param,
+                results_.entry))
             {
                 results_.entry =
                     sm_.at(results_.entry.param, results_.token_id);
@@ -40,27 +41,31 @@ namespace parsertl
             break;
         case reduce:
         {
-            const std::size_t size_ =
-                sm_._rules[results_.entry.param]._rhs.size();
+            const std::size_t size_ = sm_.rule_size(results_.entry.param);
 
             if (size_)
             {
                 results_.stack.resize(results_.stack.size() - size_);
             }
 
-            results_.token_id = sm_._rules[results_.entry.param]._lhs;
+            results_.token_id = sm_.rule_lhs(results_.entry.param);
             results_.entry = sm_.at(results_.stack.back(), results_.token_id);
             break;
         }
         case go_to:
             results_.stack.push_back(results_.entry.param);
             results_.token_id = iter_->id;
-            results_.entry = sm_.at(results_.stack.back(), results_.token_id);
+
+            if (!sm_.default_reduction(results_.stack.back(), results_.entry))
+            {
+                results_.entry =
+                    sm_.at(results_.stack.back(), results_.token_id);
+            }
+
             break;
         case accept:
         {
-            const std::size_t size_ =
-                sm_._rules[results_.entry.param]._rhs.size();
+            const std::size_t size_ = sm_.rule_size(results_.entry.param);
 
             if (size_)
             {
@@ -73,12 +78,20 @@ namespace parsertl
             // error
             break;
         }
+
+        if (overflowed(results_.stack))
+        {
+            results_.entry.action = error;
+            results_.entry.param = storage_overflow;
+        }
     }
 
     // Parse sequence and maintain production vector
-    template<typename lexer_iterator, typename sm_type, typename token_vector>
+    template<typename lexer_iterator, typename sm_type, typename stack_type,
+        typename token_vector>
     void lookup(lexer_iterator& iter_, const sm_type& sm_,
-        basic_match_results<sm_type>& results_, token_vector& productions_)
+        basic_match_results<sm_type, stack_type>& results_,
+        token_vector& productions_)
     {
         switch (results_.entry.action)
         {
@@ -97,7 +110,8 @@ namespace parsertl
                 results_.entry.action = error;
                 results_.entry.param = unknown_token;
             }
-            else
+            else if (!sm_.default_reduction(results_.entry.param,
+                results_.entry))
             {
                 results_.entry =
                     sm_.at(results_.entry.param, results_.token_id);
@@ -106,8 +120,7 @@ namespace parsertl
             break;
         case reduce:
         {
-            const std::size_t size_ =
-                sm_._rules[results_.entry.param]._rhs.size();
+            const std::size_t size_ = sm_.rule_size(results_.entry.param);
             typename token_vector::value_type token_;
 
             if (size_)
@@ -129,7 +142,7 @@ namespace parsertl
                 }
             }
 
-            results_.token_id = sm_._rules[results_.entry.param]._lhs;
+            results_.token_id = sm_.rule_lhs(results_.entry.param);
             results_.entry = sm_.at(results_.stack.back(), results_.token_id);
             token_.id = results_.token_id;
             productions_.push_back(token_);
@@ -138,12 +151,17 @@ namespace parsertl
         case go_to:
             results_.stack.push_back(results_.entry.param);
             results_.token_id = iter_->id;
-            results_.entry = sm_.at(results_.stack.back(), results_.token_id);
+
+            if (!sm_.default_reduction(results_.stack.back(), results_.entry))
+            {
+                results_.entry =
+                    sm_.at(results_.stack.back(), results_.token_id);
+            }
+
             break;
         case accept:
         {
-            const std::size_t size_ =
-                sm_._rules[results_.entry.param]._rhs.size();
+            const std::size_t size_ = sm_.rule_size(results_.entry.param);
 
             if (size_)
             {
@@ -156,6 +174,12 @@ namespace parsertl
             // error
             break;
         }
+
+        if (overflowed(results_.stack) || overflowed(productions_))
+        {
+            results_.entry.action = error;
+            results_.entry.param = storage_overflow;
+        }
     }
 }
 
@@ -20,20 +20,63 @@ namespace parsertl
         return parse(iter_, sm_, results_);
     }
 
+    // As above with the state stack supplied by the caller.
+    template<typename lexer_iterator, typename sm_type, typename stack_type>
+    bool match(lexer_iterator iter_, const sm_type& sm_,
+        basic_match_results<sm_type, stack_type>& results_)
+    {
+        results_.reset(iter_->id, sm_);
+        return parse(iter_, sm_, results_);
+    }
+
     template<typename lexer_iterator, typename sm_type, typename captures>
     bool match(lexer_iterator iter_, const sm_type& sm_, captures& captures_)
     {
-        basic_match_results<sm_type> results_(iter_->id, sm_);
+        basic_match_results<sm_type> results_;
         // Qualify token to prevent arg dependant lookup
         typedef parsertl::token<lexer_iterator> token;
-        typedef typename lexer_iterator::value_type::iter_type iter_type;
         typename token::token_vector productions_;
 
+        return match(iter_, sm_, captures_, results_, productions_);
+    }
+
+    // As above with the captures, state stack and productions supplied
+    // by the caller. If they are all fixed_vectors (captures_ holding a
+    // fixed_vector per capture) nothing is allocated.
+    template<typename lexer_iterator, typename sm_type, typename captures,
+        typename stack_type, typename token_vector>
+    bool match(lexer_iterator iter_, const sm_type& sm_, captures& captures_,
+        basic_match_results<sm_type, stack_type>& results_,
+        token_vector& productions_)
+    {
+        typedef typename token_vector::value_type token;
+        typedef typename lexer_iterator::value_type::iter_type iter_type;
+        const std::size_t size_ = sm_._captures.back().first +
+            sm_._captures.back().second.size() + 1;
+
+        results_.reset(iter_->id, sm_);
+        productions_.clear();
         captures_.clear();
-        captures_.resize(sm_._captures.back().first +
-            sm_._captures.back().second.size() + 1);
-        captures_[0].push_back(std::pair<iter_type, iter_type>
-            (iter_->first, iter_->second));
+        captures_.resize(size_);
+
+        if (!overflowed(captures_))
+        {
+            // A fixed_vector keeps its elements across clear()/resize()
+            for (std::size_t i_ = 0; i_ < size_; ++i_)
+            {
+                captures_[i_].clear();
+            }
+
+            captures_[0].push_back(std::pair<iter_type, iter_type>
+                (iter_->first, iter_->second));
+        }
+
+        if (overflowed(captures_) || overflowed(captures_[0]))
+        {
+            results_.entry.action = error;
+            results_.entry.param = storage_overflow;
+            return false;
+        }
 
         while (results_.entry.action != error &&
             results_.entry.action != accept)
@@ -59,9 +102,15 @@ namespace parsertl
                             productions_);
 
                         captures_[row_.first + index_ + 1].
-                            push_back(std::pair<typename token::iter_type,
-                                typename token::iter_type>(token1_.first,
-                                token2_.second));
+                            push_back(std::pair<iter_type, iter_type>
+                                (token1_.first, token2_.second));
+
+                        if (overflowed(captures_[row_.first + index_ + 1]))
+                        {
+                            results_.entry.action = error;
+                            results_.entry.param = storage_overflow;
+                        }
+
                         ++index_;
                     }
                 }
@@ -6,18 +6,23 @@
 #ifndef PARSERTL_MATCH_RESULTS_HPP
 #define PARSERTL_MATCH_RESULTS_HPP
 
+#include "fixed_vector.hpp"
 #include "runtime_error.hpp"
 #include "state_machine.hpp"
 #include <vector>
 
 namespace parsertl
 {
-    template<typename sm_t>
+    // stack_t may be a fixed_vector<id_type> over caller storage, in
+    // which case parse(), lookup() and match() do not allocate.
+    template<typename sm_t,
+        typename stack_t = std::vector<typename sm_t::id_type> >
     struct basic_match_results
     {
         typedef sm_t sm_type;
         typedef typename sm_type::id_type id_type;
-        std::vector<id_type> stack;
+        typedef stack_t stack_type;
+        stack_type stack;
         id_type token_id;
         typename sm_type::entry entry;
 
@@ -30,9 +35,12 @@ namespace parsertl
         }
 
         basic_match_results(const std::size_t reserved_) :
-            stack(reserved_)
+            token_id(static_cast<id_type>(~0))
         {
-            basic_match_results();
+            stack.reserve(reserved_);
+            stack.push_back(0);
+            entry.action = error;
+            entry.param = unknown_token;
         }
 
         basic_match_results(const id_type token_id_, const sm_type& sm_)
@@ -41,10 +49,17 @@ namespace parsertl
         }
 
         basic_match_results(const id_type token_id_, const sm_type& sm_,
-            const std::size_t reserved_) :
-            stack(reserved_)
+            const std::size_t reserved_)
         {
-            basic_match_results(token_id_, sm_);
+            stack.reserve(reserved_);
+            reset(token_id_, sm_);
+        }
+
+        basic_match_results(const id_type token_id_, const sm_type& sm_,
+            const stack_type& stack_) :
+            stack(stack_)
+        {
+            reset(token_id_, sm_);
         }
 
         void clear()
@@ -61,12 +76,17 @@ namespace parsertl
             stack.push_back(0);
             token_id = token_id_;
 
-            if (token_id == static_cast<id_type>(~0))
+            if (overflowed(stack))
+            {
+                entry.action = error;
+                entry.param = storage_overflow;
+            }
+            else if (token_id == static_cast<id_type>(~0))
             {
                 entry.action = error;
                 entry.param = unknown_token;
             }
-            else
+            else if (!sm_.default_reduction(stack.back(), entry))
             {
                 entry = sm_.at(stack.back(), token_id);
             }
@@ -112,7 +132,7 @@ namespace parsertl
         std::size_t production_size(const sm_type& sm,
             const std::size_t index_) const
         {
-            return sm._rules[index_]._rhs.size();
+            return sm.rule_size(index_);
         }
 
         bool operator ==(const basic_match_results& rhs_) const
@@ -126,6 +146,11 @@ namespace parsertl
     typedef basic_match_results<state_machine> match_results;
     typedef basic_match_results<uncompressed_state_machine>
         uncompressed_match_results;
+    typedef basic_match_results<classed_state_machine> classed_match_results;
+    typedef basic_match_results<csr_state_machine> csr_match_results;
+    typedef basic_match_results<comb_state_machine> comb_match_results;
+    typedef basic_match_results<packed_state_machine> packed_match_results;
+    typedef basic_match_results<split_state_machine> split_match_results;
 }
 
 #endif
@@ -12,16 +12,113 @@ namespace parsertl
 {
     typedef std::vector<char> char_vector;
 
+    // Fixed size set of terminal ids packed into words.
+    // The word loops have no data dependent branches so that
+    // compilers can vectorise them.
+    class bit_vector
+    {
+    public:
+        typedef std::size_t word;
+
+        enum { word_bits = sizeof(word) * 8 };
+
+        explicit bit_vector(const std::size_t size_ = 0) :
+            _size(size_),
+            _words((size_ + word_bits - 1) / word_bits, 0)
+        {
+        }
+
+        std::size_t size() const
+        {
+            return _size;
+        }
+
+        bool test(const std::size_t index_) const
+        {
+            return (_words[index_ / word_bits] & mask(index_)) != 0;
+        }
+
+        // Return true if index_ was not already set.
+        bool set(const std::size_t index_)
+        {
+            word& word_ = _words[index_ / word_bits];
+            const word old_ = word_;
+
+            word_ |= mask(index_);
+            return word_ != old_;
+        }
+
+        // Add every element of rhs_. Return true if this set changes.
+        bool set_union(const bit_vector& rhs_)
+        {
+            word changes_ = 0;
+
+            for (std::size_t idx_ = 0, size_ = _words.size();
+                idx_ < size_; ++idx_)
+            {
+                const word old_ = _words[idx_];
+
+                _words[idx_] = old_ | rhs_._words[idx_];
+                changes_ |= _words[idx_] ^ old_;
+            }
+
+            return changes_ != 0;
+        }
+
+        // Lowest set index >= index_, or size() if there is none.
+        std::size_t find_next(std::size_t index_) const
+        {
+            if (index_ >= _size) return _size;
+
+            std::size_t idx_ = index_ / word_bits;
+            word word_ = _words[idx_] >> (index_ % word_bits);
+
+            while (!word_)
+            {
+                if (++idx_ == _words.size()) return _size;
+
+                word_ = _words[idx_];
+                index_ = idx_ * word_bits;
+            }
+
+            for (; !(word_ & 1); word_ >>= 1)
+            {
+                ++index_;
+            }
+
+            return index_;
+        }
+
+        std::size_t find_first() const
+        {
+            return find_next(0);
+        }
+
+        bool operator==(const bit_vector& rhs_) const
+        {
+            return _size == rhs_._size && _words == rhs_._words;
+        }
+
+    private:
+        std::size_t _size;
+        std::vector<word> _words;
+
+        static word mask(const std::size_t index_)
+        {
+            return static_cast<word>(1) << (index_ % word_bits);
+        }
+    };
+
     struct nt_info
     {
         bool _nullable;
-        char_vector _first_set;
-        char_vector _follow_set;
+        bit_vector _first_set;
+        bit_vector _follow_set;
 
         nt_info(const std::size_t terminals_) :
             _nullable(false),
-            _first_set(terminals_, 0),
-            _follow_set(terminals_, 0)
+            _first_set(terminals_),
+            _follow_set(terminals_)
         {
         }
     };
@@ -12,9 +12,9 @@
 namespace parsertl
 {
     // Parse entire sequence and return boolean
-    template<typename lexer_iterator, typename sm_type>
+    template<typename lexer_iterator, typename sm_type, typename stack_type>
     bool parse(lexer_iterator& iter_, const sm_type& sm_,
-        basic_match_results<sm_type>& results_)
+        basic_match_results<sm_type, stack_type>& results_)
     {
         while (results_.entry.action != error)
         {
@@ -33,7 +33,8 @@ namespace parsertl
                     results_.entry.action = error;
                     results_.entry.param = unknown_token;
                 }
-                else
+                else if (!sm_.default_reduction(results_.stack.back(),
+                    results_.entry))
                 {
                     results_.entry =
                         sm_.at(results_.stack.back(), results_.token_id);
@@ -42,24 +43,206 @@ namespace parsertl
                 break;
             case reduce:
             {
-                const std::size_t size_ =
-                    sm_._rules[results_.entry.param]._rhs.size();
+                const std::size_t size_ = sm_.rule_size(results_.entry.param);
 
                 if (size_)
                 {
                     results_.stack.resize(results_.stack.size() - size_);
                 }
 
-                results_.token_id = sm_._rules[results_.entry.param]._lhs;
+                results_.token_id = sm_.rule_lhs(results_.entry.param);
                 results_.entry =
                     sm_.at(results_.stack.back(), results_.token_id);
+
+                // Take the goto now rather than on the next iteration.
+                if (results_.entry.action == go_to)
+                {
+                    results_.stack.push_back(results_.entry.param);
+                    results_.token_id = iter_->id;
+
+                    if (!sm_.default_reduction(results_.stack.back(),
+                        results_.entry))
+                    {
+                        results_.entry =
+                            sm_.at(results_.stack.back(), results_.token_id);
+                    }
+                }
+
                 break;
             }
             case go_to:
                 results_.stack.push_back(results_.entry.param);
                 results_.token_id = iter_->id;
+
+                if (!sm_.default_reduction(results_.stack.back(),
+                    results_.entry))
+                {
+                    results_.entry =
+                        sm_.at(results_.stack.back(), results_.token_id);
+                }
+
+                break;
+            default:
+                // accept
+                // error
+                break;
+            }
+
+            if (overflowed(results_.stack))
+            {
+                results_.entry.action = error;
+                results_.entry.param = storage_overflow;
+            }
+            else if (results_.entry.action == accept)
+            {
+                const std::size_t size_ = sm_.rule_size(results_.entry.param);
+
+                if (size_)
+                {
+                    results_.stack.resize(results_.stack.size() - size_);
+                }
+
+                break;
+            }
+        }
+
+        return results_.entry.action == accept;
+    }
+
+    // What a reduction action sees: the rule being reduced and its rhs.
+    template<typename sm_type, typename token_vector>
+    struct reduction
+    {
+        typedef typename token_vector::value_type token;
+
+        const sm_type& sm;
+        const basic_match_results<sm_type>& results;
+        token_vector& productions;
+
+        reduction(const sm_type& sm_,
+            const basic_match_results<sm_type>& results_,
+            token_vector& productions_) :
+            sm(sm_),
+            results(results_),
+            productions(productions_)
+        {
+        }
+
+        std::size_t rule() const
+        {
+            return results.entry.param;
+        }
+
+        std::size_t size() const
+        {
+            return sm.rule_size(results.entry.param);
+        }
+
+        token& dollar(const std::size_t index_) const
+        {
+            return productions[productions.size() - size() + index_];
+        }
+
+    private:
+        reduction& operator=(const reduction&);
+    };
+
+    // Parse entire sequence, calling action_(reduction) before each
+    // reduction. action_ is usually a function object switching on
+    // rule(), which the compiler can inline.
+    template<typename lexer_iterator, typename sm_type, typename token_vector,
+        typename functor>
+    bool parse(lexer_iterator& iter_, const sm_type& sm_,
+        basic_match_results<sm_type>& results_, token_vector& productions_,
+        functor& action_)
+    {
+        typedef typename token_vector::value_type token;
+        const reduction<sm_type, token_vector>
+            reduction_(sm_, results_, productions_);
+
+        while (results_.entry.action != error)
+        {
+            switch (results_.entry.action)
+            {
+            case shift:
+                results_.stack.push_back(results_.entry.param);
+                productions_.push_back(token(iter_->id, iter_->first,
+                    iter_->second));
+
+                if (iter_->id != 0)
+                    ++iter_;
+
+                results_.token_id = iter_->id;
+
+                if (results_.token_id == lexer_iterator::value_type::npos())
+                {
+                    results_.entry.action = error;
+                    results_.entry.param = unknown_token;
+                }
+                else if (!sm_.default_reduction(results_.stack.back(),
+                    results_.entry))
+                {
+                    results_.entry =
+                        sm_.at(results_.stack.back(), results_.token_id);
+                }
+
+                break;
+            case reduce:
+            {
+                const std::size_t size_ = sm_.rule_size(results_.entry.param);
+                token token_;
+
+                action_(reduction_);
+
+                if (size_)
+                {
+                    results_.stack.resize(results_.stack.size() - size_);
+                    token_.first = (productions_.end() - size_)->first;
+                    token_.second = productions_.back().second;
+                    productions_.resize(productions_.size() - size_);
+                }
+                else if (productions_.empty())
+                {
+                    token_.first = token_.second = iter_->first;
+                }
+                else
+                {
+                    token_.first = token_.second = productions_.back().second;
+                }
+
+                results_.token_id = sm_.rule_lhs(results_.entry.param);
                 results_.entry =
                     sm_.at(results_.stack.back(), results_.token_id);
+                token_.id = results_.token_id;
+                productions_.push_back(token_);
+
+                // Take the goto now rather than on the next iteration.
+                if (results_.entry.action == go_to)
+                {
+                    results_.stack.push_back(results_.entry.param);
+                    results_.token_id = iter_->id;
+
+                    if (!sm_.default_reduction(results_.stack.back(),
+                        results_.entry))
+                    {
+                        results_.entry =
+                            sm_.at(results_.stack.back(), results_.token_id);
+                    }
+                }
+
+                break;
+            }
+            case go_to:
+                results_.stack.push_back(results_.entry.param);
+                results_.token_id = iter_->id;
+
+                if (!sm_.default_reduction(results_.stack.back(),
+                    results_.entry))
+                {
+                    results_.entry =
+                        sm_.at(results_.stack.back(), results_.token_id);
+                }
+
                 break;
             default:
                 // accept
@@ -69,8 +252,7 @@ namespace parsertl
 
             if (results_.entry.action == accept)
             {
-                const std::size_t size_ =
-                    sm_._rules[results_.entry.param]._rhs.size();
+                const std::size_t size_ = sm_.rule_size(results_.entry.param);
 
                 if (size_)
                 {
@@ -83,6 +265,58 @@ namespace parsertl
 
         return results_.entry.action == accept;
     }
+
+    template<typename callback>
+    struct action_table
+    {
+        const callback* _actions;
+        std::size_t _size;
+
+        action_table(const callback* actions_, const std::size_t size_) :
+            _actions(actions_),
+            _size(size_)
+        {
+        }
+
+        template<typename reduction_type>
+        void operator()(const reduction_type& reduction_) const
+        {
+            const std::size_t rule_ = reduction_.rule();
+
+            if (rule_ < _size)
+                call(_actions[rule_], reduction_);
+        }
+
+    private:
+        template<typename function, typename reduction_type>
+        static void call(const function& function_,
+            const reduction_type& reduction_)
+        {
+            function_(reduction_);
+        }
+
+        // Rules without an action can be left null.
+        template<typename reduction_type>
+        static void call(void (* const function_)(const reduction_type&),
+            const reduction_type& reduction_)
+        {
+            if (function_)
+                function_(reduction_);
+        }
+    };
+
+    // As above, calling actions_[rule] for each rule reduced that is
+    // below size_. Rule ids are sm_._rules indexes.
+    template<typename lexer_iterator, typename sm_type, typename token_vector,
+        typename callback>
+    bool parse(lexer_iterator& iter_, const sm_type& sm_,
+        basic_match_results<sm_type>& results_, token_vector& productions_,
+        const callback* actions_, const std::size_t size_)
+    {
+        const action_table<callback> table_(actions_, size_);
+
+        return parse(iter_, sm_, results_, productions_, table_);
+    }
 }
 
 #endif
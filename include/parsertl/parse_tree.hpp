@@ -0,0 +1,253 @@
+// parse_tree.hpp
+// Copyright (c) 2017-2023 Ben Hanson (http://www.benhanson.net/)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file licence_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef PARSERTL_PARSE_TREE_HPP
+#define PARSERTL_PARSE_TREE_HPP
+
+#include "lookup.hpp"
+#include "match_results.hpp"
+#include "runtime_error.hpp"
+#include <vector>
+
+namespace parsertl
+{
+    // A parse tree stored in postorder in one vector. Every node is
+    // followed by its parent, so the subtree of node n is the range
+    // [first(n), n] and a subtree is just an index. Spans are offsets
+    // from the base iterator. While parsing the vector holds a forest:
+    // one subtree per symbol on the parse stack.
+    // Nodes hold ids as id_type and everything else as 32 bit offsets,
+    // so a node is 24 bytes with the default id_type. Inputs of 4GB or
+    // more throw rather than wrap.
+    template<typename iter_type, typename id_ty = unsigned int>
+    class basic_parse_tree
+    {
+    public:
+        typedef id_ty id_type;
+        typedef unsigned int offset_type;
+
+        struct node
+        {
+            // Token id, or lhs id (sm_type::rule_lhs()) for a rule.
+            id_type id;
+            // Rule id, or npos() for a token.
+            id_type rule;
+            offset_type children;
+            // Number of nodes in the subtree including this one.
+            offset_type size;
+            offset_type first;
+            offset_type second;
+
+            node() :
+                id(npos()),
+                rule(npos()),
+                children(0),
+                size(1),
+                first(0),
+                second(0)
+            {
+            }
+
+            bool is_token() const
+            {
+                return rule == npos();
+            }
+        };
+
+        typedef std::vector<node> node_vector;
+
+        explicit basic_parse_tree(const iter_type& base_ = iter_type()) :
+            _base(base_)
+        {
+        }
+
+        // Drops the tree but keeps its storage.
+        void clear()
+        {
+            _nodes.clear();
+        }
+
+        void reset(const iter_type& base_)
+        {
+            _base = base_;
+            _nodes.clear();
+        }
+
+        void reserve(const std::size_t size_)
+        {
+            _nodes.reserve(size_);
+        }
+
+        bool empty() const
+        {
+            return _nodes.empty();
+        }
+
+        std::size_t size() const
+        {
+            return _nodes.size();
+        }
+
+        const node& operator[](const std::size_t index_) const
+        {
+            return _nodes[index_];
+        }
+
+        const node_vector& nodes() const
+        {
+            return _nodes;
+        }
+
+        // Node spans are offsets from here.
+        const iter_type& base() const
+        {
+            return _base;
+        }
+
+        // After an accepting parse the root is the last node.
+        std::size_t root() const
+        {
+            return _nodes.size() - 1;
+        }
+
+        // The first node of the subtree rooted at index_.
+        std::size_t first(const std::size_t index_) const
+        {
+            return index_ + 1 - _nodes[index_].size;
+        }
+
+        // Only valid if the node has children.
+        std::size_t last_child(const std::size_t index_) const
+        {
+            return index_ - 1;
+        }
+
+        // Only valid if the node is not the first child.
+        std::size_t prev_sibling(const std::size_t index_) const
+        {
+            return index_ - _nodes[index_].size;
+        }
+
+        void shift(const std::size_t id_, const iter_type& first_,
+            const iter_type& second_)
+        {
+            node node_;
+
+            node_.id = static_cast<id_type>(id_);
+            node_.first = offset(first_);
+            node_.second = offset(second_);
+            _nodes.push_back(node_);
+        }
+
+        // Makes the last children_ subtrees the children of a new node.
+        // An empty rule is placed at the end of the previous node, or at
+        // first_ if there is none.
+        void reduce(const std::size_t rule_, const std::size_t id_,
+            const std::size_t children_, const iter_type& first_)
+        {
+            node node_;
+            std::size_t index_ = _nodes.size();
+
+            for (std::size_t c_ = 0; c_ < children_; ++c_)
+            {
+                index_ -= _nodes[index_ - 1].size;
+            }
+
+            node_.id = static_cast<id_type>(id_);
+            node_.rule = static_cast<id_type>(rule_);
+            node_.children = static_cast<offset_type>(children_);
+            node_.size = static_cast<offset_type>(_nodes.size() - index_ + 1);
+
+            if (children_)
+            {
+                node_.first = _nodes[index_].first;
+                node_.second = _nodes.back().second;
+            }
+            else
+            {
+                node_.first = node_.second = _nodes.empty() ?
+                    offset(first_) : _nodes.back().second;
+            }
+
+            _nodes.push_back(node_);
+        }
+
+        void pop_back()
+        {
+            _nodes.pop_back();
+        }
+
+        static id_type npos()
+        {
+            return static_cast<id_type>(~0);
+        }
+
+    private:
+        iter_type _base;
+        node_vector _nodes;
+
+        offset_type offset(const iter_type& iter_) const
+        {
+            const std::size_t offset_ =
+                static_cast<std::size_t>(iter_ - _base);
+
+            if (offset_ > static_cast<offset_type>(~0))
+            {
+                throw runtime_error("basic_parse_tree offsets are limited "
+                    "to 32 bits.");
+            }
+
+            return static_cast<offset_type>(offset_);
+        }
+    };
+
+    // Parse entire sequence, building the tree as lookup() goes.
+    // The end of input token is not kept in the tree and spans are
+    // offsets from the start of the first token.
+    template<typename lexer_iterator, typename sm_type, typename id_type>
+    bool parse(lexer_iterator& iter_, const sm_type& sm_,
+        basic_match_results<sm_type>& results_,
+        basic_parse_tree<typename lexer_iterator::value_type::iter_type,
+            id_type>& tree_)
+    {
+        tree_.reset(iter_->first);
+
+        while (results_.entry.action != error &&
+            results_.entry.action != accept)
+        {
+            switch (results_.entry.action)
+            {
+            case shift:
+                if (iter_->id != 0)
+                    tree_.shift(iter_->id, iter_->first, iter_->second);
+
+                break;
+            case reduce:
+                tree_.reduce(results_.entry.param,
+                    sm_.rule_lhs(results_.entry.param),
+                    sm_.rule_size(results_.entry.param), iter_->first);
+                break;
+            default:
+                break;
+            }
+
+            lookup(iter_, sm_, results_);
+        }
+
+        if (results_.entry.action == accept)
+        {
+            // Pop the accept rule's stack entries.
+            lookup(iter_, sm_, results_);
+            return true;
+        }
+
+        return false;
+    }
+
+    typedef basic_parse_tree<const char*> parse_tree;
+    typedef basic_parse_tree<const wchar_t*> wparse_tree;
+}
+
+#endif
@@ -0,0 +1,232 @@
+// push_parser.hpp
+// Copyright (c) 2017-2023 Ben Hanson (http://www.benhanson.net/)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file licence_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef PARSERTL_PUSH_PARSER_HPP
+#define PARSERTL_PUSH_PARSER_HPP
+
+#include <lexertl/iterator.hpp>
+#include "match_results.hpp"
+#include "token.hpp"
+#include <vector>
+
+namespace parsertl
+{
+    // Parses tokens handed to push() one at a time instead of pulling
+    // them from a lexer_iterator, so the input never has to be in one
+    // buffer. lexer_iterator only supplies the token type.
+    template<typename lexer_iterator, typename sm_type>
+    class basic_push_parser
+    {
+    public:
+        typedef basic_match_results<sm_type> results;
+        typedef typename sm_type::id_type id_type;
+        // Qualify token to prevent arg dependant lookup
+        typedef parsertl::token<lexer_iterator> token;
+        typedef typename token::token_vector token_vector;
+
+        explicit basic_push_parser(const sm_type& sm_) :
+            _sm(sm_),
+            _waiting(true)
+        {
+        }
+
+        // Start a new parse, e.g. after accept or error.
+        void reset()
+        {
+            _results.clear();
+            _productions.clear();
+            _reductions.clear();
+            _waiting = true;
+        }
+
+        // Feed the next token, with id 0 for end of input. Returns shift
+        // once the token has been consumed and the next one is needed,
+        // otherwise accept or error. The rule ids reduced are then in
+        // reductions().
+        action push(const token& token_)
+        {
+            recorder recorder_(_reductions);
+
+            _reductions.clear();
+            return push(token_, recorder_);
+        }
+
+        // As above, but calls handler_(*this) before each reduction, when
+        // reduce_id() and dollar() refer to the rule being reduced.
+        template<typename handler>
+        action push(const token& token_, handler& handler_)
+        {
+            // accept or error ends the parse until reset().
+            if (!_waiting) return _results.entry.action;
+
+            bool lookahead_ = true;
+
+            _waiting = false;
+            _results.token_id = static_cast<id_type>(token_.id);
+
+            if (token_.id == lexer_iterator::value_type::npos())
+            {
+                _results.entry.action = error;
+                _results.entry.param = unknown_token;
+                return error;
+            }
+
+            if (!_sm.default_reduction(_results.stack.back(),
+                _results.entry))
+            {
+                _results.entry = _sm.at(_results.stack.back(),
+                    _results.token_id);
+            }
+
+            for (;;)
+            {
+                switch (_results.entry.action)
+                {
+                case shift:
+                    _results.stack.push_back(_results.entry.param);
+                    _productions.push_back(token_);
+                    // As in lookup(), end of input remains the lookahead.
+                    lookahead_ = token_.id == 0;
+                    break;
+                case reduce:
+                {
+                    const std::size_t size_ =
+                        _sm.rule_size(_results.entry.param);
+                    token lhs_;
+
+                    handler_(*this);
+
+                    if (size_)
+                    {
+                        _results.stack.resize(_results.stack.size() - size_);
+                        lhs_.first = (_productions.end() - size_)->first;
+                        lhs_.second = _productions.back().second;
+                        _productions.resize(_productions.size() - size_);
+                    }
+                    else if (!_productions.empty())
+                    {
+                        lhs_.first = lhs_.second = _productions.back().second;
+                    }
+                    else if (lookahead_)
+                    {
+                        lhs_.first = lhs_.second = token_.first;
+                    }
+
+                    lhs_.id = _sm.rule_lhs(_results.entry.param);
+                    _productions.push_back(lhs_);
+                    // Take the goto straight away.
+                    _results.entry = _sm.at(_results.stack.back(),
+                        static_cast<id_type>(lhs_.id));
+
+                    if (_results.entry.action != go_to) continue;
+
+                    _results.stack.push_back(_results.entry.param);
+                    break;
+                }
+                case accept:
+                {
+                    const std::size_t size_ =
+                        _sm.rule_size(_results.entry.param);
+
+                    if (size_)
+                    {
+                        _results.stack.resize(_results.stack.size() - size_);
+                    }
+
+                    return accept;
+                }
+                default:
+                    // error
+                    return error;
+                }
+
+                // Default reductions need no lookahead, so they are done
+                // now rather than on the next push().
+                if (!_sm.default_reduction(_results.stack.back(),
+                    _results.entry))
+                {
+                    if (!lookahead_)
+                    {
+                        _waiting = true;
+                        return shift;
+                    }
+
+                    _results.entry = _sm.at(_results.stack.back(),
+                        _results.token_id);
+                }
+            }
+        }
+
+        // Whether push() can be called before reset().
+        bool waiting() const
+        {
+            return _waiting;
+        }
+
+        const token& dollar(const std::size_t index_) const
+        {
+            return _results.dollar(index_, _sm, _productions);
+        }
+
+        id_type reduce_id() const
+        {
+            return _results.reduce_id();
+        }
+
+        const results& state() const
+        {
+            return _results;
+        }
+
+        const token_vector& productions() const
+        {
+            return _productions;
+        }
+
+        const std::vector<id_type>& reductions() const
+        {
+            return _reductions;
+        }
+
+    private:
+        struct recorder
+        {
+            std::vector<id_type>& _reductions;
+
+            recorder(std::vector<id_type>& reductions_) :
+                _reductions(reductions_)
+            {
+            }
+
+            void operator()(const basic_push_parser& parser_)
+            {
+                _reductions.push_back(parser_.reduce_id());
+            }
+
+        private:
+            recorder& operator=(const recorder&);
+        };
+
+        const sm_type& _sm;
+        results _results;
+        token_vector _productions;
+        std::vector<id_type> _reductions;
+        // A token is needed to continue.
+        bool _waiting;
+
+        basic_push_parser& operator=(const basic_push_parser&);
+    };
+
+    typedef basic_push_parser<lexertl::siterator, state_machine>
+        spush_parser;
+    typedef basic_push_parser<lexertl::citerator, state_machine>
+        cpush_parser;
+    typedef basic_push_parser<lexertl::wsiterator, state_machine>
+        wspush_parser;
+    typedef basic_push_parser<lexertl::wciterator, state_machine>
+        wcpush_parser;
+}
+
+#endif
@@ -103,13 +103,17 @@ namespace parsertl
             associativity _associativity;
             std::size_t _index;
             std::size_t _next_lhs;
+            // The reduction must be reported even when
+            // enable_unit_elimination would bypass it (see keep()).
+            bool _keep;
 
             production(const std::size_t index_) :
                 _lhs(static_cast<std::size_t>(~0)),
                 _precedence(0),
                 _associativity(token_assoc),
                 _index(index_),
-                _next_lhs(static_cast<std::size_t>(~0))
+                _next_lhs(static_cast<std::size_t>(~0)),
+                _keep(false)
             {
             }
 
@@ -122,6 +126,7 @@ namespace parsertl
                 _associativity = token_assoc;
                 _index = static_cast<std::size_t>(~0);
                 _next_lhs = static_cast<std::size_t>(~0);
+                _keep = false;
             }
         };
 
@@ -211,6 +216,11 @@ namespace parsertl
             _flags = flags_;
         }
 
+        std::size_t flags() const
+        {
+            return _flags;
+        }
+
         void token(const char_type* names_)
         {
             lexer_iterator iter_(names_, str_end(names_), _token_lexer);
@@ -546,6 +556,22 @@ namespace parsertl
             return index_;
         }
 
+        // Flag production index_ (as returned by push()) as having a
+        // semantic action, so that enable_unit_elimination never bypasses
+        // its reduction. Productions with captures are always kept.
+        void keep(const id_type index_)
+        {
+            if (index_ >= _grammar.size())
+            {
+                std::ostringstream ss_;
+
+                ss_ << "Invalid production index " << index_ << '.';
+                throw runtime_error(ss_.str());
+            }
+
+            _grammar[index_]._keep = true;
+        }
+
         id_type token_id(const string& name_) const
         {
             typename string_id_type_map::const_iterator iter_ =
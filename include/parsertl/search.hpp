@@ -344,6 +344,7 @@ namespace parsertl
             {
             case shift:
             {
+                // Default reduction rows keep their $ entry for this.
                 const typename sm_type::entry eoi_ =
                     sm_.at(results_.entry.param);
 
@@ -359,7 +360,8 @@ namespace parsertl
                     results_.entry.action = error;
                     results_.entry.param = unknown_token;
                 }
-                else
+                else if (!sm_.default_reduction(results_.entry.param,
+                    results_.entry))
                 {
                     results_.entry =
                         sm_.at(results_.entry.param, results_.token_id);
@@ -377,8 +379,7 @@ namespace parsertl
             }
             case reduce:
             {
-                const std::size_t size_ =
-                    sm_._rules[results_.entry.param]._rhs.size();
+                const std::size_t size_ = sm_.rule_size(results_.entry.param);
 
                 if (prod_set_)
                 {
@@ -390,7 +391,7 @@ namespace parsertl
                     results_.stack.resize(results_.stack.size() - size_);
                 }
 
-                results_.token_id = sm_._rules[results_.entry.param]._lhs;
+                results_.token_id = sm_.rule_lhs(results_.entry.param);
                 results_.entry =
                     sm_.at(results_.stack.back(), results_.token_id);
                 break;
@@ -398,13 +399,18 @@ namespace parsertl
             case go_to:
                 results_.stack.push_back(results_.entry.param);
                 results_.token_id = iter_->id;
-                results_.entry =
-                    sm_.at(results_.stack.back(), results_.token_id);
+
+                if (!sm_.default_reduction(results_.stack.back(),
+                    results_.entry))
+                {
+                    results_.entry =
+                        sm_.at(results_.stack.back(), results_.token_id);
+                }
+
                 break;
             case accept:
             {
-                const std::size_t size_ =
-                    sm_._rules[results_.entry.param]._rhs.size();
+                const std::size_t size_ = sm_.rule_size(results_.entry.param);
 
                 if (size_)
                 {
@@ -429,6 +435,7 @@ namespace parsertl
             {
             case shift:
             {
+                // Default reduction rows keep their $ entry for this.
                 const typename sm_type::entry eoi_ =
                     sm_.at(results_.entry.param);
 
@@ -446,7 +453,8 @@ namespace parsertl
                     results_.entry.action = error;
                     results_.entry.param = unknown_token;
                 }
-                else
+                else if (!sm_.default_reduction(results_.entry.param,
+                    results_.entry))
                 {
                     results_.entry =
                         sm_.at(results_.entry.param, results_.token_id);
@@ -461,8 +469,7 @@ namespace parsertl
             }
             case reduce:
             {
-                const std::size_t size_ =
-                    sm_._rules[results_.entry.param]._rhs.size();
+                const std::size_t size_ = sm_.rule_size(results_.entry.param);
                 token<lexer_iterator> token_;
 
                 if (size_)
@@ -485,7 +492,7 @@ namespace parsertl
                     }
                 }
 
-                results_.token_id = sm_._rules[results_.entry.param]._lhs;
+                results_.token_id = sm_.rule_lhs(results_.entry.param);
                 results_.entry =
                     sm_.at(results_.stack.back(), results_.token_id);
                 token_.id = results_.token_id;
@@ -495,13 +502,18 @@ namespace parsertl
             case go_to:
                 results_.stack.push_back(results_.entry.param);
                 results_.token_id = iter_->id;
-                results_.entry =
-                    sm_.at(results_.stack.back(), results_.token_id);
+
+                if (!sm_.default_reduction(results_.stack.back(),
+                    results_.entry))
+                {
+                    results_.entry =
+                        sm_.at(results_.stack.back(), results_.token_id);
+                }
+
                 break;
             case accept:
             {
-                const std::size_t size_ =
-                    sm_._rules[results_.entry.param]._rhs.size();
+                const std::size_t size_ = sm_.rule_size(results_.entry.param);
 
                 if (size_)
                 {
@@ -538,7 +550,8 @@ namespace parsertl
                         results_.entry.action = error;
                         results_.entry.param = unknown_token;
                     }
-                    else
+                    else if (!sm_.default_reduction(results_.stack.back(),
+                        results_.entry))
                     {
                         results_.entry =
                             sm_.at(results_.stack.back(), results_.token_id);
@@ -548,7 +561,7 @@ namespace parsertl
                 case reduce:
                 {
                     const std::size_t size_ =
-                        sm_._rules[results_.entry.param]._rhs.size();
+                        sm_.rule_size(results_.entry.param);
 
                     if (prod_set_)
                     {
@@ -560,7 +573,7 @@ namespace parsertl
                         results_.stack.resize(results_.stack.size() - size_);
                     }
 
-                    results_.token_id = sm_._rules[results_.entry.param]._lhs;
+                    results_.token_id = sm_.rule_lhs(results_.entry.param);
                     results_.entry =
                         sm_.at(results_.stack.back(), results_.token_id);
                     break;
@@ -568,8 +581,14 @@ namespace parsertl
                 case go_to:
                     results_.stack.push_back(results_.entry.param);
                     results_.token_id = iter_->id;
-                    results_.entry =
-                        sm_.at(results_.stack.back(), results_.token_id);
+
+                    if (!sm_.default_reduction(results_.stack.back(),
+                        results_.entry))
+                    {
+                        results_.entry =
+                            sm_.at(results_.stack.back(), results_.token_id);
+                    }
+
                     break;
                 default:
                     // error
@@ -579,7 +598,7 @@ namespace parsertl
                 if (results_.entry.action == accept)
                 {
                     const std::size_t size_ =
-                        sm_._rules[results_.entry.param]._rhs.size();
+                        sm_.rule_size(results_.entry.param);
 
                     if (size_)
                     {
@@ -618,7 +637,8 @@ namespace parsertl
                         results_.entry.action = error;
                         results_.entry.param = unknown_token;
                     }
-                    else
+                    else if (!sm_.default_reduction(results_.stack.back(),
+                        results_.entry))
                     {
                         results_.entry =
                             sm_.at(results_.stack.back(), results_.token_id);
@@ -628,7 +648,7 @@ namespace parsertl
                 case reduce:
                 {
                     const std::size_t size_ =
-                        sm_._rules[results_.entry.param]._rhs.size();
+                        sm_.rule_size(results_.entry.param);
                     token<lexer_iterator> token_;
 
                     if (size_)
@@ -660,7 +680,7 @@ namespace parsertl
                         }
                     }
 
-                    results_.token_id = sm_._rules[results_.entry.param]._lhs;
+                    results_.token_id = sm_.rule_lhs(results_.entry.param);
                     results_.entry =
                         sm_.at(results_.stack.back(), results_.token_id);
                     token_.id = results_.token_id;
@@ -670,8 +690,14 @@ namespace parsertl
                 case go_to:
                     results_.stack.push_back(results_.entry.param);
                     results_.token_id = iter_->id;
-                    results_.entry =
-                        sm_.at(results_.stack.back(), results_.token_id);
+
+                    if (!sm_.default_reduction(results_.stack.back(),
+                        results_.entry))
+                    {
+                        results_.entry =
+                            sm_.at(results_.stack.back(), results_.token_id);
+                    }
+
                     break;
                 default:
                     // accept
@@ -682,7 +708,7 @@ namespace parsertl
                 if (results_.entry.action == accept)
                 {
                     const std::size_t size_ =
-                        sm_._rules[results_.entry.param]._rhs.size();
+                        sm_.rule_size(results_.entry.param);
 
                     if (size_)
                     {
@@ -724,7 +750,8 @@ namespace parsertl
                             static_cast<typename sm_type::id_type>
                             (unknown_token);
                     }
-                    else
+                    else if (!sm_.default_reduction(results_.stack.back(),
+                        results_.entry))
                     {
                         results_.entry =
                             sm_.at(results_.stack.back(), results_.token_id);
@@ -734,7 +761,7 @@ namespace parsertl
                 case reduce:
                 {
                     const std::size_t size_ =
-                        sm_._rules[results_.entry.param]._rhs.size();
+                        sm_.rule_size(results_.entry.param);
                     token<lexer_iterator> token_;
 
                     if (size_)
@@ -764,7 +791,7 @@ namespace parsertl
                         }
                     }
 
-                    results_.token_id = sm_._rules[results_.entry.param]._lhs;
+                    results_.token_id = sm_.rule_lhs(results_.entry.param);
                     results_.entry =
                         sm_.at(results_.stack.back(), results_.token_id);
                     token_.id = results_.token_id;
@@ -774,8 +801,14 @@ namespace parsertl
                 case go_to:
                     results_.stack.push_back(results_.entry.param);
                     results_.token_id = iter_->id;
-                    results_.entry =
-                        sm_.at(results_.stack.back(), results_.token_id);
+
+                    if (!sm_.default_reduction(results_.stack.back(),
+                        results_.entry))
+                    {
+                        results_.entry =
+                            sm_.at(results_.stack.back(), results_.token_id);
+                    }
+
                     break;
                 default:
                     // accept
@@ -785,8 +818,8 @@ namespace parsertl
 
                 if (results_.entry.action == accept)
                 {
-                    const std::size_t size_ = sm_._rules[results_.entry.param].
-                        _rhs.size();
+                    const std::size_t size_ =
+                        sm_.rule_size(results_.entry.param);
 
                     if (size_)
                     {
@@ -18,9 +18,10 @@ namespace parsertl
         typedef basic_state_machine<id_type> sm_type;
 
         // Version number
-        stream_ << 1 << '\n';
+        stream_ << 3 << '\n';
         stream_ << sizeof(id_type) << '\n';
         stream_ << sm_._columns << '\n';
+        stream_ << sm_._terminals << '\n';
         stream_ << sm_._rows << '\n';
         stream_ << sm_._rules.size() << '\n';
 
@@ -54,6 +55,7 @@ namespace parsertl
             }
         }
 
+        lexertl::detail::output_vec<char>(sm_._default_reductions, stream_);
         stream_ << sm_._table.size() << '\n';
 
         for (std::size_t idx_ = 0, size_ = sm_._table.size();
@@ -81,10 +83,11 @@ namespace parsertl
     {
         typedef basic_state_machine<id_type> sm_type;
         std::size_t num_ = 0;
+        std::size_t version_ = 0;
 
         sm_.clear();
         // Version
-        stream_ >> num_;
+        stream_ >> version_;
         // sizeof(id_type)
         stream_ >> num_;
 
@@ -92,6 +95,10 @@ namespace parsertl
             throw runtime_error("id_type mismatch in parsertl::load()");
 
         stream_ >> sm_._columns;
+
+        if (version_ > 2)
+            stream_ >> sm_._terminals;
+
         stream_ >> sm_._rows;
         stream_ >> num_;
 
@@ -105,6 +112,8 @@ namespace parsertl
             lexertl::detail::input_vec<char>(stream_, rule_._rhs);
         }
 
+        sm_.flatten_rules();
+
         stream_ >> num_;
 
         for (std::size_t idx_ = 0, rows_ = num_; idx_ < rows_; ++idx_)
@@ -131,6 +140,24 @@ namespace parsertl
             }
         }
 
+        if (version_ < 3)
+        {
+            // The lowest lhs is the first non-terminal.
+            sm_._terminals = sm_._columns;
+
+            for (std::size_t idx_ = 0, size_ = sm_._rules.size();
+                idx_ < size_; ++idx_)
+            {
+                sm_._terminals = std::min(sm_._terminals,
+                    static_cast<std::size_t>(sm_._rules[idx_]._lhs));
+            }
+        }
+
+        if (version_ > 1)
+        {
+            lexertl::detail::input_vec<char>(stream_, sm_._default_reductions);
+        }
+
         stream_ >> num_;
         sm_._table.reserve(num_);
 
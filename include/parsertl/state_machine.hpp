@@ -10,6 +10,9 @@
 #include <lexertl/compile_assert.hpp>
 #include "enums.hpp"
 #include <deque>
+#include <map>
+#include "runtime_error.hpp"
+#include <sstream>
 #include <vector>
 
 namespace parsertl
@@ -37,10 +40,42 @@ namespace parsertl
 
         typedef std::deque<id_type_vector_pair> rules;
 
+        // What a reduce by a rule needs, without its rhs.
+        struct rule_info
+        {
+            id_type _lhs;
+            id_type _size;
+
+            rule_info() :
+                _lhs(0),
+                _size(0)
+            {
+            }
+
+            rule_info(const id_type lhs_, const id_type size_) :
+                _lhs(lhs_),
+                _size(size_)
+            {
+            }
+        };
+
+        typedef std::vector<rule_info> rule_info_vector;
+
         std::size_t _columns;
+        // Columns [0, _terminals) are terminals (ACTION),
+        // the rest are non-terminals (GOTO).
+        std::size_t _terminals;
         std::size_t _rows;
         rules _rules;
+        // Flat copy of the lhs and rhs size of each of _rules, so that a
+        // reduce is a single load (see flatten_rules()).
+        rule_info_vector _rule_info;
         captures_deque _captures;
+        // Rule to reduce by regardless of lookahead for each row
+        // (~0 if none). Only populated when building with
+        // enable_default_reductions, in which case those rows hold only
+        // their $ entry, which search() uses to find where input can end.
+        id_type_vector _default_reductions;
 
         // If you get a compile error here you have
         // failed to define an unsigned id type.
@@ -81,6 +116,7 @@ namespace parsertl
 
         base_state_machine() :
             _columns(0),
+            _terminals(0),
             _rows(0)
         {
         }
@@ -92,9 +128,47 @@ namespace parsertl
 
         virtual void clear()
         {
-            _columns = _rows = 0;
+            _columns = _terminals = _rows = 0;
             _rules.clear();
+            _rule_info.clear();
             _captures.clear();
+            _default_reductions.clear();
+        }
+
+        // Fill _rule_info from _rules.
+        // Call this if you populate _rules by hand.
+        void flatten_rules()
+        {
+            _rule_info.clear();
+            _rule_info.reserve(_rules.size());
+
+            for (typename rules::const_iterator iter_ = _rules.begin(),
+                end_ = _rules.end(); iter_ != end_; ++iter_)
+            {
+                _rule_info.push_back(rule_info(iter_->_lhs,
+                    static_cast<id_type>(iter_->_rhs.size())));
+            }
+        }
+
+        // Number of symbols on the rhs of rule_
+        std::size_t rule_size(const std::size_t rule_) const
+        {
+            return _rule_info[rule_]._size;
+        }
+
+        id_type rule_lhs(const std::size_t rule_) const
+        {
+            return _rule_info[rule_]._lhs;
+        }
+
+        bool default_reduction(const std::size_t state_, entry& entry_) const
+        {
+            if (_default_reductions.empty() ||
+                _default_reductions[state_] == static_cast<id_type>(~0))
+                return false;
+
+            entry_ = entry(reduce, _default_reductions[state_]);
+            return true;
         }
     };
 
@@ -188,6 +262,11 @@ namespace parsertl
             _table.resize(base_sm::_rows);
         }
 
+        void clear_row(const std::size_t state_)
+        {
+            pair_vector().swap(_table[state_]);
+        }
+
     private:
         struct pred
         {
@@ -252,11 +331,1377 @@ namespace parsertl
         {
             _table.resize(base_sm::_columns * base_sm::_rows);
         }
+
+        void clear_row(const std::size_t state_)
+        {
+            typename table::iterator iter_ =
+                _table.begin() + state_ * base_sm::_columns;
+
+            std::fill(iter_, iter_ + base_sm::_columns, entry());
+        }
+    };
+
+    // Uses a 2d array with row and column equivalence classes.
+    // Tokens with identical columns share a column class (see _translate,
+    // which plays the same role as yytranslate) and states with identical
+    // rows then share a row. The generator builds a basic_state_machine
+    // and groups it with assign(). A table filled through set() is dense
+    // until compress() is called.
+    template<typename id_ty>
+    struct basic_classed_state_machine : base_state_machine<id_ty>
+    {
+        typedef base_state_machine<id_ty> base_sm;
+        typedef id_ty id_type;
+        typedef typename base_sm::entry entry;
+        typedef typename base_sm::id_type_vector id_type_vector;
+        typedef std::vector<entry> table;
+
+        // Token id to column class
+        id_type_vector _translate;
+        // State to row class
+        id_type_vector _row_classes;
+        std::size_t _classes;
+        table _table;
+
+        basic_classed_state_machine() :
+            _classes(0)
+        {
+        }
+
+        virtual ~basic_classed_state_machine()
+        {
+        }
+
+        virtual void clear()
+        {
+            base_sm::clear();
+            _translate.clear();
+            _row_classes.clear();
+            _classes = 0;
+            _table.clear();
+        }
+
+        bool empty() const
+        {
+            return _table.empty();
+        }
+
+        entry at(const std::size_t state_) const
+        {
+            return _table[_row_classes[state_] * _classes + _translate[0]];
+        }
+
+        entry at(const std::size_t state_, const std::size_t token_id_) const
+        {
+            return _table[_row_classes[state_] * _classes +
+                _translate[token_id_]];
+        }
+
+        void set(const std::size_t state_, const std::size_t token_id_,
+            const entry& entry_)
+        {
+            expand();
+            _table[state_ * _classes + token_id_] = entry_;
+        }
+
+        void push()
+        {
+            _table.resize(base_sm::_columns * base_sm::_rows);
+            _classes = base_sm::_columns;
+            identity(_translate, base_sm::_columns);
+            identity(_row_classes, base_sm::_rows);
+        }
+
+        void clear_row(const std::size_t state_)
+        {
+            typename table::iterator iter_;
+
+            expand();
+            iter_ = _table.begin() + state_ * _classes;
+            std::fill(iter_, iter_ + _classes, entry());
+        }
+
+        // Merge identical columns and then identical rows.
+        void compress()
+        {
+            typedef std::map<id_type_vector, id_type> class_map;
+            const std::size_t columns_ = base_sm::_columns;
+            const std::size_t rows_ = base_sm::_rows;
+            class_map map_;
+            id_type_vector key_;
+            size_t_vector class_columns_;
+            table table_;
+
+            expand();
+
+            for (std::size_t id_ = 0; id_ < columns_; ++id_)
+            {
+                key_.clear();
+
+                for (std::size_t state_ = 0; state_ < rows_; ++state_)
+                    push_entry(key_, _table[state_ * columns_ + id_]);
+
+                std::pair<typename class_map::iterator, bool> pair_ =
+                    map_.insert(typename class_map::value_type(key_,
+                        static_cast<id_type>(class_columns_.size())));
+
+                if (pair_.second)
+                    class_columns_.push_back(id_);
+
+                _translate[id_] = pair_.first->second;
+            }
+
+            _classes = class_columns_.size();
+            map_.clear();
+
+            for (std::size_t state_ = 0; state_ < rows_; ++state_)
+            {
+                const std::size_t row_class_ = table_.size() / _classes;
+
+                key_.clear();
+
+                for (std::size_t class_ = 0; class_ < _classes; ++class_)
+                    push_entry(key_, _table[state_ * columns_ +
+                        class_columns_[class_]]);
+
+                std::pair<typename class_map::iterator, bool> pair_ =
+                    map_.insert(typename class_map::value_type(key_,
+                        static_cast<id_type>(row_class_)));
+
+                if (pair_.second)
+                {
+                    for (std::size_t class_ = 0; class_ < _classes; ++class_)
+                        table_.push_back(_table[state_ * columns_ +
+                            class_columns_[class_]]);
+                }
+
+                _row_classes[state_] = pair_.first->second;
+            }
+
+            _table.swap(table_);
+        }
+
+        // Groups the columns and rows of a sparse table without
+        // expanding it, so memory stays proportional to the cells of
+        // sm_ plus the compressed table. The generator builds via this.
+        void assign(const basic_state_machine<id_type>& sm_)
+        {
+            typedef typename basic_state_machine<id_type>::pair_vector
+                pair_vector;
+            typedef std::map<id_type_vector, id_type> class_map;
+            const std::size_t columns_ = sm_._columns;
+            const std::size_t rows_ = sm_._table.size();
+            std::vector<id_type_vector> column_keys_(columns_);
+            class_map map_;
+            class_entry_vector row_;
+            id_type_vector key_;
+
+            clear();
+            static_cast<base_sm&>(*this) = sm_;
+            _translate.resize(columns_);
+            _row_classes.resize(rows_);
+
+            // A column's key is its non empty cells in state order.
+            for (std::size_t state_ = 0; state_ < rows_; ++state_)
+            {
+                const pair_vector& pairs_ = sm_._table[state_];
+
+                for (typename pair_vector::const_iterator iter_ =
+                    pairs_.begin(), end_ = pairs_.end(); iter_ != end_;
+                    ++iter_)
+                {
+                    if (iter_->_entry == entry())
+                        continue;
+
+                    id_type_vector& column_ = column_keys_[iter_->_id];
+
+                    column_.push_back(static_cast<id_type>(state_));
+                    push_entry(column_, iter_->_entry);
+                }
+            }
+
+            for (std::size_t id_ = 0; id_ < columns_; ++id_)
+            {
+                std::pair<typename class_map::iterator, bool> pair_ =
+                    map_.insert(typename class_map::value_type
+                        (column_keys_[id_], static_cast<id_type>
+                            (_classes)));
+
+                if (pair_.second)
+                    ++_classes;
+
+                _translate[id_] = pair_.first->second;
+            }
+
+            std::vector<id_type_vector>().swap(column_keys_);
+            map_.clear();
+
+            // A row's key is its non empty cells in class order.
+            for (std::size_t state_ = 0; state_ < rows_; ++state_)
+            {
+                const pair_vector& pairs_ = sm_._table[state_];
+
+                row_.clear();
+                key_.clear();
+
+                for (typename pair_vector::const_iterator iter_ =
+                    pairs_.begin(), end_ = pairs_.end(); iter_ != end_;
+                    ++iter_)
+                {
+                    if (!(iter_->_entry == entry()))
+                        row_.push_back(class_entry(_translate[iter_->_id],
+                            iter_->_entry));
+                }
+
+                std::sort(row_.begin(), row_.end(), class_less());
+
+                for (typename class_entry_vector::const_iterator iter_ =
+                    row_.begin(), end_ = row_.end(); iter_ != end_; ++iter_)
+                {
+                    // Every token of a class has the same entry.
+                    if (!key_.empty() && key_[key_.size() - 3] ==
+                        iter_->first)
+                        continue;
+
+                    key_.push_back(iter_->first);
+                    push_entry(key_, iter_->second);
+                }
+
+                const std::size_t row_class_ = map_.size();
+                std::pair<typename class_map::iterator, bool> pair_ =
+                    map_.insert(typename class_map::value_type(key_,
+                        static_cast<id_type>(row_class_)));
+
+                if (pair_.second)
+                {
+                    _table.resize(_table.size() + _classes);
+
+                    for (typename class_entry_vector::const_iterator iter_ =
+                        row_.begin(), end_ = row_.end(); iter_ != end_;
+                        ++iter_)
+                    {
+                        _table[row_class_ * _classes + iter_->first] =
+                            iter_->second;
+                    }
+                }
+
+                _row_classes[state_] = pair_.first->second;
+            }
+        }
+
+        void assign(const basic_uncompressed_state_machine<id_type>& sm_)
+        {
+            clear();
+            static_cast<base_sm&>(*this) = sm_;
+            push();
+            _table = sm_._table;
+            compress();
+        }
+
+    private:
+        typedef std::vector<std::size_t> size_t_vector;
+        typedef std::pair<id_type, entry> class_entry;
+        typedef std::vector<class_entry> class_entry_vector;
+
+        struct class_less
+        {
+            bool operator()(const class_entry& lhs_,
+                const class_entry& rhs_) const
+            {
+                return lhs_.first < rhs_.first;
+            }
+        };
+
+        static void identity(id_type_vector& vec_, const std::size_t size_)
+        {
+            vec_.resize(size_);
+
+            for (std::size_t idx_ = 0; idx_ < size_; ++idx_)
+                vec_[idx_] = static_cast<id_type>(idx_);
+        }
+
+        static void push_entry(id_type_vector& key_, const entry& entry_)
+        {
+            key_.push_back(static_cast<id_type>(entry_.action));
+            key_.push_back(entry_.param);
+        }
+
+        // Undo compress() so that individual cells can be changed.
+        void expand()
+        {
+            const std::size_t columns_ = base_sm::_columns;
+            const std::size_t rows_ = base_sm::_rows;
+
+            if (_table.size() == columns_ * rows_ && _classes == columns_)
+                return;
+
+            table table_(columns_ * rows_);
+
+            for (std::size_t state_ = 0; state_ < rows_; ++state_)
+            {
+                for (std::size_t id_ = 0; id_ < columns_; ++id_)
+                    table_[state_ * columns_ + id_] = at(state_, id_);
+            }
+
+            _table.swap(table_);
+            _classes = columns_;
+            identity(_translate, columns_);
+            identity(_row_classes, rows_);
+        }
+    };
+
+    // Uses compressed sparse rows for the state machine.
+    // The token ids and entries of all rows are held in two contiguous
+    // vectors, so that scanning a row for an id touches only the ids.
+    // Row n occupies [_offsets[n], _offsets[n + 1]).
+    // set() and clear_row() shift every later row, so the generator
+    // builds a basic_state_machine and flattens it with assign().
+    template<typename id_ty>
+    struct basic_csr_state_machine : base_state_machine<id_ty>
+    {
+        typedef base_state_machine<id_ty> base_sm;
+        typedef id_ty id_type;
+        typedef typename base_sm::entry entry;
+        typedef typename base_sm::id_type_vector id_type_vector;
+        typedef std::vector<std::size_t> offset_vector;
+        typedef std::vector<entry> entry_vector;
+
+        offset_vector _offsets;
+        id_type_vector _ids;
+        entry_vector _entries;
+
+        // No need to specify constructor.
+        virtual ~basic_csr_state_machine()
+        {
+        }
+
+        virtual void clear()
+        {
+            base_sm::clear();
+            _offsets.clear();
+            _ids.clear();
+            _entries.clear();
+        }
+
+        bool empty() const
+        {
+            return _offsets.empty();
+        }
+
+        entry at(const std::size_t state_) const
+        {
+            return at(state_, 0);
+        }
+
+        entry at(const std::size_t state_, const std::size_t token_id_) const
+        {
+            const std::size_t index_ = find(state_, token_id_);
+
+            if (index_ == _offsets[state_ + 1])
+                return entry();
+            else
+                return _entries[index_];
+        }
+
+        void set(const std::size_t state_, const std::size_t token_id_,
+            const entry& entry_)
+        {
+            const std::size_t index_ = find(state_, token_id_);
+
+            if (index_ == _offsets[state_ + 1])
+            {
+                // The generator fills rows in order,
+                // so this is normally an append.
+                _ids.insert(_ids.begin() + index_,
+                    static_cast<id_type>(token_id_));
+                _entries.insert(_entries.begin() + index_, entry_);
+
+                for (std::size_t idx_ = state_ + 1, size_ = _offsets.size();
+                    idx_ < size_; ++idx_)
+                {
+                    ++_offsets[idx_];
+                }
+            }
+            else
+            {
+                _entries[index_] = entry_;
+            }
+        }
+
+        void push()
+        {
+            _offsets.resize(base_sm::_rows + 1, _ids.size());
+        }
+
+        void clear_row(const std::size_t state_)
+        {
+            const std::size_t first_ = _offsets[state_];
+            const std::size_t size_ = _offsets[state_ + 1] - first_;
+
+            _ids.erase(_ids.begin() + first_, _ids.begin() + first_ + size_);
+            _entries.erase(_entries.begin() + first_,
+                _entries.begin() + first_ + size_);
+
+            for (std::size_t idx_ = state_ + 1, offsets_ = _offsets.size();
+                idx_ < offsets_; ++idx_)
+            {
+                _offsets[idx_] -= size_;
+            }
+        }
+
+        // Flatten an existing table.
+        void assign(const basic_state_machine<id_type>& sm_)
+        {
+            typedef typename basic_state_machine<id_type>::pair_vector
+                pair_vector;
+            std::size_t size_ = 0;
+
+            clear();
+            static_cast<base_sm&>(*this) = sm_;
+
+            for (std::size_t state_ = 0, rows_ = sm_._table.size();
+                state_ < rows_; ++state_)
+            {
+                size_ += sm_._table[state_].size();
+            }
+
+            _offsets.reserve(sm_._rows + 1);
+            _ids.reserve(size_);
+            _entries.reserve(size_);
+            _offsets.push_back(0);
+
+            for (std::size_t state_ = 0, rows_ = sm_._table.size();
+                state_ < rows_; ++state_)
+            {
+                const pair_vector& row_ = sm_._table[state_];
+
+                for (typename pair_vector::const_iterator iter_ =
+                    row_.begin(), end_ = row_.end(); iter_ != end_; ++iter_)
+                {
+                    _ids.push_back(iter_->_id);
+                    _entries.push_back(iter_->_entry);
+                }
+
+                _offsets.push_back(_ids.size());
+            }
+        }
+
+    private:
+        // Returns the end of the row if token_id_ is not present.
+        std::size_t find(const std::size_t state_,
+            const std::size_t token_id_) const
+        {
+            std::size_t index_ = _offsets[state_];
+            const std::size_t last_ = _offsets[state_ + 1];
+
+            for (; index_ != last_; ++index_)
+            {
+                if (_ids[index_] == token_id_)
+                    break;
+            }
+
+            return index_;
+        }
+    };
+
+    // Uses yacc style row displacement ("comb") vectors for the state machine
+    template<typename id_ty>
+    struct basic_comb_state_machine : base_state_machine<id_ty>
+    {
+        typedef base_state_machine<id_ty> base_sm;
+        typedef id_ty id_type;
+        typedef typename base_sm::entry entry;
+        typedef std::vector<std::size_t> base_vector;
+        typedef std::vector<id_type> check_vector;
+        typedef std::vector<entry> next_vector;
+
+        // Offset of each row into _check and _next
+        base_vector _base;
+        // Row owning each slot (npos() if the slot is free)
+        check_vector _check;
+        next_vector _next;
+        // Every slot below this one is in use
+        std::size_t _free;
+
+        basic_comb_state_machine() :
+            _free(0)
+        {
+        }
+
+        virtual ~basic_comb_state_machine()
+        {
+        }
+
+        virtual void clear()
+        {
+            base_sm::clear();
+            _base.clear();
+            _check.clear();
+            _next.clear();
+            _free = 0;
+        }
+
+        bool empty() const
+        {
+            return _base.empty();
+        }
+
+        entry at(const std::size_t state_) const
+        {
+            return at(state_, 0);
+        }
+
+        entry at(const std::size_t state_, const std::size_t token_id_) const
+        {
+            const std::size_t index_ = _base[state_] + token_id_;
+
+            if (index_ < _check.size() &&
+                _check[index_] == static_cast<id_type>(state_))
+                return _next[index_];
+            else
+                return entry();
+        }
+
+        void set(const std::size_t state_, const std::size_t token_id_,
+            const entry& entry_)
+        {
+            std::size_t index_ = _base[state_] + token_id_;
+
+            if (index_ >= _check.size())
+            {
+                resize(index_ + 1);
+                _check[index_] = static_cast<id_type>(state_);
+                skip_used();
+            }
+            else if (_check[index_] == npos())
+            {
+                _check[index_] = static_cast<id_type>(state_);
+                skip_used();
+            }
+            else if (_check[index_] != static_cast<id_type>(state_))
+            {
+                // Slot is owned by another row, so move this one.
+                index_ = relocate(state_, token_id_);
+            }
+
+            _next[index_] = entry_;
+        }
+
+        void push()
+        {
+            _base.resize(base_sm::_rows, 0);
+        }
+
+        void clear_row(const std::size_t state_)
+        {
+            const std::size_t base_ = _base[state_];
+
+            for (std::size_t id_ = 0; id_ < base_sm::_columns &&
+                base_ + id_ < _check.size(); ++id_)
+            {
+                const std::size_t index_ = base_ + id_;
+
+                if (_check[index_] == static_cast<id_type>(state_))
+                {
+                    free_slot(index_);
+                }
+            }
+        }
+
+        // Pack an existing table.
+        // This gives a tighter fit than filling via set().
+        void assign(const basic_state_machine<id_type>& sm_)
+        {
+            copy(sm_);
+            pack(sm_._table);
+        }
+
+        void assign(const basic_uncompressed_state_machine<id_type>& sm_)
+        {
+            pair_table table_(sm_._rows);
+
+            copy(sm_);
+
+            for (std::size_t state_ = 0; state_ < sm_._rows; ++state_)
+            {
+                for (std::size_t id_ = 0; id_ < sm_._columns; ++id_)
+                {
+                    const entry entry_ = sm_.at(state_, id_);
+
+                    if (entry_.action != error || entry_.param != syntax_error)
+                        table_[state_].push_back(state_pair(static_cast
+                            <id_type>(id_), entry_));
+                }
+            }
+
+            pack(table_);
+        }
+
+    private:
+        typedef typename basic_state_machine<id_type>::state_pair state_pair;
+        typedef typename basic_state_machine<id_type>::pair_vector pair_vector;
+        typedef typename basic_state_machine<id_type>::table pair_table;
+        typedef std::vector<std::size_t> size_t_vector;
+
+        static id_type npos()
+        {
+            return static_cast<id_type>(~0);
+        }
+
+        void copy(const base_sm& sm_)
+        {
+            clear();
+            static_cast<base_sm&>(*this) = sm_;
+            push();
+        }
+
+        void pack(const pair_table& table_)
+        {
+            typedef std::pair<std::size_t, std::size_t> size_pair;
+            std::vector<size_pair> order_;
+            size_t_vector ids_;
+
+            order_.reserve(table_.size());
+
+            for (std::size_t state_ = 0, size_ = table_.size();
+                state_ < size_; ++state_)
+            {
+                if (!table_[state_].empty())
+                    order_.push_back(size_pair(table_[state_].size(), state_));
+            }
+
+            // Place the densest rows first as they are the hardest to fit.
+            std::sort(order_.begin(), order_.end(), greater());
+
+            for (typename std::vector<size_pair>::const_iterator iter_ =
+                order_.begin(), end_ = order_.end(); iter_ != end_; ++iter_)
+            {
+                const pair_vector& row_ = table_[iter_->second];
+                std::size_t base_ = 0;
+
+                ids_.clear();
+
+                for (typename pair_vector::const_iterator pi_ = row_.begin(),
+                    pe_ = row_.end(); pi_ != pe_; ++pi_)
+                {
+                    ids_.push_back(pi_->_id);
+                }
+
+                base_ = find_base(ids_);
+                _base[iter_->second] = base_;
+
+                for (typename pair_vector::const_iterator pi_ = row_.begin(),
+                    pe_ = row_.end(); pi_ != pe_; ++pi_)
+                {
+                    const std::size_t index_ = base_ + pi_->_id;
+
+                    _check[index_] = static_cast<id_type>(iter_->second);
+                    _next[index_] = pi_->_entry;
+                }
+
+                skip_used();
+            }
+        }
+
+        std::size_t relocate(const std::size_t state_,
+            const std::size_t token_id_)
+        {
+            const std::size_t old_base_ = _base[state_];
+            size_t_vector ids_;
+            next_vector entries_;
+            std::size_t new_base_ = 0;
+
+            for (std::size_t id_ = 0; id_ < base_sm::_columns &&
+                old_base_ + id_ < _check.size(); ++id_)
+            {
+                const std::size_t index_ = old_base_ + id_;
+
+                if (_check[index_] == static_cast<id_type>(state_))
+                {
+                    ids_.push_back(id_);
+                    entries_.push_back(_next[index_]);
+                    free_slot(index_);
+                }
+            }
+
+            ids_.push_back(token_id_);
+            entries_.push_back(entry());
+            new_base_ = find_base(ids_);
+            _base[state_] = new_base_;
+
+            for (std::size_t idx_ = 0, size_ = ids_.size();
+                idx_ < size_; ++idx_)
+            {
+                const std::size_t index_ = new_base_ + ids_[idx_];
+
+                _check[index_] = static_cast<id_type>(state_);
+                _next[index_] = entries_[idx_];
+            }
+
+            skip_used();
+            return new_base_ + token_id_;
+        }
+
+        // First fit. Grows the vectors so that every id fits.
+        // As with bison, the search starts where the lowest id lands on
+        // the lowest free slot, as every base below that is taken.
+        std::size_t find_base(const size_t_vector& ids_)
+        {
+            const std::size_t first_ =
+                *std::min_element(ids_.begin(), ids_.end());
+            std::size_t base_ = _free > first_ ? _free - first_ : 0;
+
+            for (;; ++base_)
+            {
+                typename size_t_vector::const_iterator iter_ = ids_.begin();
+                typename size_t_vector::const_iterator end_ = ids_.end();
+
+                // Cheap rejection on the first id.
+                if (base_ + first_ < _check.size() &&
+                    _check[base_ + first_] != npos())
+                    continue;
+
+                for (; iter_ != end_; ++iter_)
+                {
+                    const std::size_t index_ = base_ + *iter_;
+
+                    if (index_ < _check.size() && _check[index_] != npos())
+                        break;
+                }
+
+                if (iter_ == end_)
+                    break;
+            }
+
+            const std::size_t last_ =
+                base_ + *std::max_element(ids_.begin(), ids_.end());
+
+            if (last_ >= _check.size())
+                resize(last_ + 1);
+
+            return base_;
+        }
+
+        void free_slot(const std::size_t index_)
+        {
+            _check[index_] = npos();
+            _next[index_] = entry();
+
+            if (index_ < _free)
+                _free = index_;
+        }
+
+        void skip_used()
+        {
+            const std::size_t size_ = _check.size();
+
+            while (_free < size_ && _check[_free] != npos())
+                ++_free;
+        }
+
+        void resize(const std::size_t size_)
+        {
+            _check.resize(size_, npos());
+            _next.resize(size_);
+        }
+
+        struct greater
+        {
+            bool operator()(const std::pair<std::size_t, std::size_t>& lhs_,
+                const std::pair<std::size_t, std::size_t>& rhs_) const
+            {
+                return lhs_.first > rhs_.first ||
+                    (lhs_.first == rhs_.first && lhs_.second < rhs_.second);
+            }
+        };
+    };
+
+    // Keeps terminals (ACTION) and non-terminals (GOTO) in separate tables.
+    // ACTION is a comb table over the terminal columns only. GOTO is
+    // indexed by non-terminal as with bison's yypgoto/yydefgoto: each
+    // non-terminal has an offset into _goto_check/_goto_next (indexed by
+    // state) and optionally a default target, so that a goto costs a
+    // single check regardless of the grammar size.
+    template<typename id_ty>
+    struct basic_split_state_machine : base_state_machine<id_ty>
+    {
+        typedef base_state_machine<id_ty> base_sm;
+        typedef id_ty id_type;
+        typedef typename base_sm::entry entry;
+        typedef typename base_sm::id_type_vector id_type_vector;
+        typedef std::vector<std::size_t> base_vector;
+
+        basic_comb_state_machine<id_type> _action;
+        // Offset of each non-terminal into _goto_check and _goto_next
+        base_vector _goto_base;
+        // Target for states not found in _goto_check (npos() if none)
+        id_type_vector _goto_default;
+        // Non-terminal owning each slot (npos() if the slot is free)
+        id_type_vector _goto_check;
+        id_type_vector _goto_next;
+        // Every slot below this one is in use
+        std::size_t _goto_free;
+
+        basic_split_state_machine() :
+            _goto_free(0)
+        {
+        }
+
+        virtual ~basic_split_state_machine()
+        {
+        }
+
+        virtual void clear()
+        {
+            base_sm::clear();
+            _action.clear();
+            _goto_base.clear();
+            _goto_default.clear();
+            _goto_check.clear();
+            _goto_next.clear();
+            _goto_free = 0;
+        }
+
+        bool empty() const
+        {
+            return _action.empty();
+        }
+
+        entry at(const std::size_t state_) const
+        {
+            return _action.at(state_, 0);
+        }
+
+        entry at(const std::size_t state_, const std::size_t token_id_) const
+        {
+            if (token_id_ < base_sm::_terminals)
+                return _action.at(state_, token_id_);
+
+            const std::size_t nt_ = token_id_ - base_sm::_terminals;
+            const std::size_t index_ = _goto_base[nt_] + state_;
+
+            if (index_ < _goto_check.size() &&
+                _goto_check[index_] == static_cast<id_type>(nt_))
+                return entry(go_to, _goto_next[index_]);
+            else if (_goto_default[nt_] != npos())
+                return entry(go_to, _goto_default[nt_]);
+            else
+                return entry();
+        }
+
+        // Only go_to entries may be set for non-terminals.
+        void set(const std::size_t state_, const std::size_t token_id_,
+            const entry& entry_)
+        {
+            if (token_id_ < base_sm::_terminals)
+            {
+                _action.set(state_, token_id_, entry_);
+                return;
+            }
+
+            const std::size_t nt_ = token_id_ - base_sm::_terminals;
+            std::size_t index_ = _goto_base[nt_] + state_;
+
+            if (index_ >= _goto_check.size())
+            {
+                resize(index_ + 1);
+            }
+            else if (_goto_check[index_] != npos() &&
+                _goto_check[index_] != static_cast<id_type>(nt_))
+            {
+                // Slot is owned by another non-terminal, so move this one.
+                index_ = relocate(nt_, state_);
+            }
+
+            _goto_check[index_] = static_cast<id_type>(nt_);
+            _goto_next[index_] = entry_.param;
+            skip_used();
+        }
+
+        void push()
+        {
+            _action._columns = base_sm::_terminals;
+            _action._rows = base_sm::_rows;
+            _action.push();
+            _goto_base.resize(base_sm::_columns - base_sm::_terminals, 0);
+            _goto_default.resize(_goto_base.size(), npos());
+        }
+
+        void clear_row(const std::size_t state_)
+        {
+            _action.clear_row(state_);
+
+            for (std::size_t nt_ = 0, size_ = _goto_base.size();
+                nt_ < size_; ++nt_)
+            {
+                const std::size_t index_ = _goto_base[nt_] + state_;
+
+                if (index_ < _goto_check.size() &&
+                    _goto_check[index_] == static_cast<id_type>(nt_))
+                    free_slot(index_);
+            }
+        }
+
+        // Split an existing table.
+        // The most common target of each non-terminal becomes its default,
+        // which means that at() also returns it for states that have no
+        // goto on that non-terminal. The parser never asks for those.
+        void assign(const basic_state_machine<id_type>& sm_)
+        {
+            typedef typename basic_state_machine<id_type>::pair_vector
+                pair_vector;
+            const std::size_t terminals_ = sm_._terminals;
+            basic_state_machine<id_type> action_;
+            std::vector<std::vector<id_type_pair> >
+                gotos_(sm_._columns - terminals_);
+            typedef std::pair<std::size_t, std::size_t> size_pair;
+            std::vector<size_pair> order_;
+
+            clear();
+            static_cast<base_sm&>(*this) = sm_;
+            push();
+            action_._columns = action_._terminals = terminals_;
+            action_._rows = sm_._rows;
+            action_.push();
+
+            for (std::size_t state_ = 0, rows_ = sm_._table.size();
+                state_ < rows_; ++state_)
+            {
+                const pair_vector& row_ = sm_._table[state_];
+
+                for (typename pair_vector::const_iterator iter_ =
+                    row_.begin(), end_ = row_.end(); iter_ != end_; ++iter_)
+                {
+                    if (iter_->_id < terminals_)
+                        action_._table[state_].push_back(*iter_);
+                    else
+                        gotos_[iter_->_id - terminals_].push_back
+                            (id_type_pair(static_cast<id_type>(state_),
+                                iter_->_entry.param));
+                }
+            }
+
+            _action.assign(action_);
+
+            for (std::size_t nt_ = 0, size_ = gotos_.size();
+                nt_ < size_; ++nt_)
+            {
+                std::vector<id_type_pair>& list_ = gotos_[nt_];
+
+                if (list_.empty())
+                    continue;
+
+                _goto_default[nt_] = most_common(list_);
+                list_.erase(std::remove_if(list_.begin(), list_.end(),
+                    target(_goto_default[nt_])), list_.end());
+
+                if (!list_.empty())
+                    order_.push_back(size_pair(list_.size(), nt_));
+            }
+
+            // Place the largest exception lists first
+            // as they are the hardest to fit.
+            std::sort(order_.begin(), order_.end(), greater());
+
+            for (typename std::vector<size_pair>::const_iterator iter_ =
+                order_.begin(), end_ = order_.end(); iter_ != end_; ++iter_)
+            {
+                place(iter_->second, gotos_[iter_->second]);
+            }
+        }
+
+    private:
+        typedef typename base_sm::id_type_pair id_type_pair;
+
+        static id_type npos()
+        {
+            return static_cast<id_type>(~0);
+        }
+
+        static id_type most_common(const std::vector<id_type_pair>& gotos_)
+        {
+            id_type_vector targets_;
+            id_type best_ = 0;
+            std::size_t best_count_ = 0;
+
+            targets_.reserve(gotos_.size());
+
+            for (typename std::vector<id_type_pair>::const_iterator iter_ =
+                gotos_.begin(), end_ = gotos_.end(); iter_ != end_; ++iter_)
+            {
+                targets_.push_back(iter_->second);
+            }
+
+            std::sort(targets_.begin(), targets_.end());
+
+            for (typename id_type_vector::const_iterator iter_ =
+                targets_.begin(), end_ = targets_.end(); iter_ != end_;)
+            {
+                typename id_type_vector::const_iterator next_ =
+                    std::upper_bound(iter_, end_, *iter_);
+                const std::size_t count_ = next_ - iter_;
+
+                if (count_ > best_count_)
+                {
+                    best_ = *iter_;
+                    best_count_ = count_;
+                }
+
+                iter_ = next_;
+            }
+
+            return best_;
+        }
+
+        // Stores (state, target) pairs for nt_ at the first offset where
+        // all of the states fit, starting where the lowest state lands on
+        // the lowest free slot.
+        void place(const std::size_t nt_,
+            const std::vector<id_type_pair>& gotos_)
+        {
+            std::size_t first_ = static_cast<std::size_t>(~0);
+            std::size_t last_ = 0;
+            std::size_t base_ = 0;
+
+            for (typename std::vector<id_type_pair>::const_iterator iter_ =
+                gotos_.begin(), end_ = gotos_.end(); iter_ != end_; ++iter_)
+            {
+                first_ = std::min(first_,
+                    static_cast<std::size_t>(iter_->first));
+                last_ = std::max(last_,
+                    static_cast<std::size_t>(iter_->first));
+            }
+
+            base_ = _goto_free > first_ ? _goto_free - first_ : 0;
+
+            for (;; ++base_)
+            {
+                typename std::vector<id_type_pair>::const_iterator iter_ =
+                    gotos_.begin();
+                typename std::vector<id_type_pair>::const_iterator end_ =
+                    gotos_.end();
+
+                for (; iter_ != end_; ++iter_)
+                {
+                    const std::size_t index_ = base_ + iter_->first;
+
+                    if (index_ < _goto_check.size() &&
+                        _goto_check[index_] != npos())
+                        break;
+                }
+
+                if (iter_ == end_)
+                    break;
+            }
+
+            if (base_ + last_ >= _goto_check.size())
+                resize(base_ + last_ + 1);
+
+            _goto_base[nt_] = base_;
+
+            for (typename std::vector<id_type_pair>::const_iterator iter_ =
+                gotos_.begin(), end_ = gotos_.end(); iter_ != end_; ++iter_)
+            {
+                const std::size_t index_ = base_ + iter_->first;
+
+                _goto_check[index_] = static_cast<id_type>(nt_);
+                _goto_next[index_] = iter_->second;
+            }
+
+            skip_used();
+        }
+
+        std::size_t relocate(const std::size_t nt_, const std::size_t state_)
+        {
+            const std::size_t old_base_ = _goto_base[nt_];
+            std::vector<id_type_pair> gotos_;
+
+            for (std::size_t s_ = 0; s_ < base_sm::_rows &&
+                old_base_ + s_ < _goto_check.size(); ++s_)
+            {
+                const std::size_t index_ = old_base_ + s_;
+
+                if (_goto_check[index_] == static_cast<id_type>(nt_))
+                {
+                    gotos_.push_back(id_type_pair(static_cast<id_type>(s_),
+                        _goto_next[index_]));
+                    free_slot(index_);
+                }
+            }
+
+            gotos_.push_back(id_type_pair(static_cast<id_type>(state_), 0));
+            place(nt_, gotos_);
+            return _goto_base[nt_] + state_;
+        }
+
+        void free_slot(const std::size_t index_)
+        {
+            _goto_check[index_] = npos();
+
+            if (index_ < _goto_free)
+                _goto_free = index_;
+        }
+
+        void skip_used()
+        {
+            const std::size_t size_ = _goto_check.size();
+
+            while (_goto_free < size_ && _goto_check[_goto_free] != npos())
+                ++_goto_free;
+        }
+
+        void resize(const std::size_t size_)
+        {
+            _goto_check.resize(size_, npos());
+            _goto_next.resize(size_, 0);
+        }
+
+        struct target
+        {
+            id_type _target;
+
+            target(const id_type target_) :
+                _target(target_)
+            {
+            }
+
+            bool operator()(const id_type_pair& pair_) const
+            {
+                return pair_.second == _target;
+            }
+        };
+
+        struct greater
+        {
+            bool operator()(const std::pair<std::size_t, std::size_t>& lhs_,
+                const std::pair<std::size_t, std::size_t>& rhs_) const
+            {
+                return lhs_.first > rhs_.first ||
+                    (lhs_.first == rhs_.first && lhs_.second < rhs_.second);
+            }
+        };
+    };
+
+    // Uses a vector of vectors of packed cells for the state machine.
+    // Each cell is a token id and an entry word holding the action in the
+    // bottom 3 bits and the param above them. Cells start out as 16 bit
+    // words and are widened to 32 bits the first time a value won't fit.
+    // A value too large for a 32 bit cell throws runtime_error.
+    template<typename id_ty>
+    struct basic_packed_state_machine : base_state_machine<id_ty>
+    {
+        typedef base_state_machine<id_ty> base_sm;
+        typedef id_ty id_type;
+        typedef typename base_sm::entry entry;
+        typedef unsigned short narrow_word;
+        typedef unsigned int wide_word;
+
+        template<typename word_type>
+        struct cell
+        {
+            word_type _id;
+            word_type _entry;
+
+            cell() :
+                _id(0),
+                _entry(0)
+            {
+            }
+
+            cell(const word_type id_, const word_type entry_) :
+                _id(id_),
+                _entry(entry_)
+            {
+            }
+        };
+
+        typedef std::vector<cell<narrow_word> > narrow_row;
+        typedef std::vector<narrow_row> narrow_table;
+        typedef std::vector<cell<wide_word> > wide_row;
+        typedef std::vector<wide_row> wide_table;
+
+        bool _wide;
+        narrow_table _narrow_table;
+        wide_table _wide_table;
+
+        basic_packed_state_machine() :
+            _wide(false)
+        {
+        }
+
+        virtual ~basic_packed_state_machine()
+        {
+        }
+
+        virtual void clear()
+        {
+            base_sm::clear();
+            _wide = false;
+            _narrow_table.clear();
+            _wide_table.clear();
+        }
+
+        bool empty() const
+        {
+            return _wide ? _wide_table.empty() : _narrow_table.empty();
+        }
+
+        entry at(const std::size_t state_) const
+        {
+            return at(state_, 0);
+        }
+
+        entry at(const std::size_t state_, const std::size_t token_id_) const
+        {
+            return _wide ? find(_wide_table[state_], token_id_) :
+                find(_narrow_table[state_], token_id_);
+        }
+
+        void set(const std::size_t state_, const std::size_t token_id_,
+            const entry& entry_)
+        {
+            if (!_wide && (token_id_ > max_id(narrow_word()) ||
+                static_cast<std::size_t>(entry_.param) >
+                max_param(narrow_word())))
+            {
+                widen();
+            }
+
+            if (_wide && (token_id_ > max_id(wide_word()) ||
+                static_cast<std::size_t>(entry_.param) >
+                max_param(wide_word())))
+            {
+                std::ostringstream ss_;
+
+                ss_ << "basic_packed_state_machine cannot hold token id " <<
+                    token_id_ << " with param " <<
+                    static_cast<std::size_t>(entry_.param) << " (max " <<
+                    max_id(wide_word()) << " and " <<
+                    max_param(wide_word()) << ").";
+                throw runtime_error(ss_.str());
+            }
+
+            if (_wide)
+                insert(_wide_table[state_], token_id_, entry_);
+            else
+                insert(_narrow_table[state_], token_id_, entry_);
+        }
+
+        void push()
+        {
+            if (_wide)
+                _wide_table.resize(base_sm::_rows);
+            else
+                _narrow_table.resize(base_sm::_rows);
+        }
+
+        void clear_row(const std::size_t state_)
+        {
+            if (_wide)
+                wide_row().swap(_wide_table[state_]);
+            else
+                narrow_row().swap(_narrow_table[state_]);
+        }
+
+    private:
+        template<typename word_type>
+        static std::size_t max_id(const word_type)
+        {
+            return static_cast<word_type>(~0);
+        }
+
+        template<typename word_type>
+        static std::size_t max_param(const word_type)
+        {
+            return static_cast<word_type>(~0) >> 3;
+        }
+
+        template<typename word_type>
+        static word_type pack(const entry& entry_)
+        {
+            return static_cast<word_type>((static_cast<std::size_t>
+                (entry_.param) << 3) | entry_.action);
+        }
+
+        template<typename word_type>
+        static entry unpack(const word_type word_)
+        {
+            // Qualify action to prevent compilation error
+            return entry(static_cast<parsertl::action>(word_ & 7),
+                static_cast<id_type>(word_ >> 3));
+        }
+
+        template<typename word_type>
+        static entry find(const std::vector<cell<word_type> >& row_,
+            const std::size_t token_id_)
+        {
+            typedef std::vector<cell<word_type> > row;
+
+            for (typename row::const_iterator iter_ = row_.begin(),
+                end_ = row_.end(); iter_ != end_; ++iter_)
+            {
+                if (iter_->_id == token_id_)
+                    return unpack(iter_->_entry);
+            }
+
+            return entry();
+        }
+
+        template<typename word_type>
+        static void insert(std::vector<cell<word_type> >& row_,
+            const std::size_t token_id_, const entry& entry_)
+        {
+            typedef std::vector<cell<word_type> > row;
+            const word_type word_ = pack<word_type>(entry_);
+
+            for (typename row::iterator iter_ = row_.begin(),
+                end_ = row_.end(); iter_ != end_; ++iter_)
+            {
+                if (iter_->_id == token_id_)
+                {
+                    iter_->_entry = word_;
+                    return;
+                }
+            }
+
+            row_.push_back(cell<word_type>(static_cast<word_type>(token_id_),
+                word_));
+        }
+
+        void widen()
+        {
+            _wide_table.resize(_narrow_table.size());
+
+            for (std::size_t state_ = 0, size_ = _narrow_table.size();
+                state_ < size_; ++state_)
+            {
+                const narrow_row& narrow_ = _narrow_table[state_];
+                wide_row& wide_ = _wide_table[state_];
+
+                wide_.reserve(narrow_.size());
+
+                for (typename narrow_row::const_iterator iter_ =
+                    narrow_.begin(), end_ = narrow_.end();
+                    iter_ != end_; ++iter_)
+                {
+                    wide_.push_back(cell<wide_word>(iter_->_id,
+                        pack<wide_word>(unpack(iter_->_entry))));
+                }
+            }
+
+            narrow_table().swap(_narrow_table);
+            _wide = true;
+        }
     };
 
     typedef basic_state_machine<std::size_t> state_machine;
     typedef basic_uncompressed_state_machine<std::size_t>
         uncompressed_state_machine;
+    typedef basic_classed_state_machine<std::size_t> classed_state_machine;
+    typedef basic_csr_state_machine<std::size_t> csr_state_machine;
+    typedef basic_comb_state_machine<std::size_t> comb_state_machine;
+    typedef basic_packed_state_machine<std::size_t> packed_state_machine;
+    typedef basic_split_state_machine<std::size_t> split_state_machine;
 }
 
 #endif
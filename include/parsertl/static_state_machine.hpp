@@ -0,0 +1,158 @@
+// static_state_machine.hpp
+// Copyright (c) 2014-2023 Ben Hanson (http://www.benhanson.net/)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file licence_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef PARSERTL_STATIC_STATE_MACHINE_HPP
+#define PARSERTL_STATIC_STATE_MACHINE_HPP
+
+#include "state_machine.hpp"
+
+namespace parsertl
+{
+    // Read only view of a static array.
+    template<typename T>
+    struct static_array
+    {
+        typedef T value_type;
+        typedef const T* const_iterator;
+
+        const T* _data;
+        std::size_t _size;
+
+        const_iterator begin() const
+        {
+            return _data;
+        }
+
+        const_iterator end() const
+        {
+            return _data + _size;
+        }
+
+        std::size_t size() const
+        {
+            return _size;
+        }
+
+        bool empty() const
+        {
+            return _size == 0;
+        }
+
+        const T& operator[](const std::size_t index_) const
+        {
+            return _data[index_];
+        }
+
+        const T& front() const
+        {
+            return _data[0];
+        }
+
+        const T& back() const
+        {
+            return _data[_size - 1];
+        }
+    };
+
+    // Non-owning state machine over static const arrays, as written by
+    // generate_tables(). It is an aggregate so that the arrays and the
+    // state machine itself are initialised at compile time.
+    // The table is held as compressed sparse rows, in the same way as
+    // basic_csr_state_machine.
+    template<typename id_ty>
+    struct basic_static_state_machine
+    {
+        typedef id_ty id_type;
+        typedef typename base_state_machine<id_type>::entry entry;
+
+        struct id_type_pair
+        {
+            id_type first;
+            id_type second;
+        };
+
+        typedef static_array<id_type_pair> capture_vector;
+
+        struct capture
+        {
+            std::size_t first;
+            capture_vector second;
+        };
+
+        struct rule
+        {
+            id_type _lhs;
+            static_array<id_type> _rhs;
+        };
+
+        struct cell
+        {
+            unsigned char _action;
+            id_type _param;
+        };
+
+        std::size_t _columns;
+        std::size_t _terminals;
+        std::size_t _rows;
+        static_array<rule> _rules;
+        static_array<capture> _captures;
+        static_array<id_type> _default_reductions;
+        // Row n occupies [_offsets[n], _offsets[n + 1]).
+        static_array<std::size_t> _offsets;
+        static_array<id_type> _ids;
+        static_array<cell> _cells;
+
+        bool empty() const
+        {
+            return _offsets.empty();
+        }
+
+        entry at(const std::size_t state_) const
+        {
+            return at(state_, 0);
+        }
+
+        entry at(const std::size_t state_, const std::size_t token_id_) const
+        {
+            for (std::size_t index_ = _offsets[state_],
+                last_ = _offsets[state_ + 1]; index_ != last_; ++index_)
+            {
+                if (_ids[index_] == token_id_)
+                {
+                    const cell& cell_ = _cells[index_];
+
+                    // Qualify action to prevent compilation error
+                    return entry(static_cast<parsertl::action>
+                        (cell_._action), cell_._param);
+                }
+            }
+
+            return entry();
+        }
+
+        bool default_reduction(const std::size_t state_, entry& entry_) const
+        {
+            if (_default_reductions.empty() ||
+                _default_reductions[state_] == static_cast<id_type>(~0))
+                return false;
+
+            entry_ = entry(reduce, _default_reductions[state_]);
+            return true;
+        }
+
+        // Number of symbols on the rhs of rule_
+        std::size_t rule_size(const std::size_t rule_) const
+        {
+            return _rules[rule_]._rhs.size();
+        }
+
+        id_type rule_lhs(const std::size_t rule_) const
+        {
+            return _rules[rule_]._lhs;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,260 @@
+// value_stack.hpp
+// Copyright (c) 2017-2023 Ben Hanson (http://www.benhanson.net/)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file licence_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef PARSERTL_VALUE_STACK_HPP
+#define PARSERTL_VALUE_STACK_HPP
+
+#include <algorithm>
+#include "match_results.hpp"
+#include "token.hpp"
+#include <vector>
+
+namespace parsertl
+{
+    // Semantic values kept in step with basic_match_results::stack.
+    // Popped values are not destroyed but handed out again by push(),
+    // so once the stack has grown to the deepest parse it allocates
+    // nothing (nor do values that reuse their own storage on
+    // assignment, such as std::string).
+    template<typename T>
+    class value_stack
+    {
+    public:
+        typedef T value_type;
+
+        value_stack() :
+            _size(0)
+        {
+        }
+
+        explicit value_stack(const std::size_t reserved_) :
+            _size(0)
+        {
+            _values.reserve(reserved_);
+        }
+
+        // Keeps the values for reuse.
+        void clear()
+        {
+            _size = 0;
+        }
+
+        bool empty() const
+        {
+            return _size == 0;
+        }
+
+        std::size_t size() const
+        {
+            return _size;
+        }
+
+        // The new top, holding whatever value last occupied the slot.
+        value_type& push()
+        {
+            if (_size == _values.size())
+            {
+                _values.push_back(value_type());
+            }
+
+            return _values[_size++];
+        }
+
+        void pop(const std::size_t count_)
+        {
+            _size -= count_;
+        }
+
+        value_type& top()
+        {
+            return _values[_size - 1];
+        }
+
+        const value_type& top() const
+        {
+            return _values[_size - 1];
+        }
+
+        value_type& operator[](const std::size_t index_)
+        {
+            return _values[index_];
+        }
+
+        const value_type& operator[](const std::size_t index_) const
+        {
+            return _values[index_];
+        }
+
+    private:
+        std::vector<value_type> _values;
+        std::size_t _size;
+    };
+
+    // What a reduction action sees: the rhs values and the lhs value to
+    // build, which sits on top of them.
+    template<typename sm_type, typename value_type>
+    struct value_reduction
+    {
+        const sm_type& sm;
+        const basic_match_results<sm_type>& results;
+        value_stack<value_type>& values;
+
+        value_reduction(const sm_type& sm_,
+            const basic_match_results<sm_type>& results_,
+            value_stack<value_type>& values_) :
+            sm(sm_),
+            results(results_),
+            values(values_)
+        {
+        }
+
+        std::size_t rule() const
+        {
+            return results.entry.param;
+        }
+
+        std::size_t size() const
+        {
+            return sm.rule_size(results.entry.param);
+        }
+
+        value_type& dollar(const std::size_t index_) const
+        {
+            return values[values.size() - 1 - size() + index_];
+        }
+
+        value_type& lhs() const
+        {
+            return values.top();
+        }
+
+    private:
+        value_reduction& operator=(const value_reduction&);
+    };
+
+    // Parse entire sequence, keeping one value per symbol on values_.
+    // action_(token, value) sets the value of each token shifted
+    // (including end of input) and action_(reduction) builds the lhs
+    // value of each rule reduced. The lhs value then replaces the rhs
+    // values by swap(), so provide one for values that own memory.
+    // On accept values_[0] is the value of the start rule.
+    template<typename lexer_iterator, typename sm_type, typename value_type,
+        typename functor>
+    bool parse(lexer_iterator& iter_, const sm_type& sm_,
+        basic_match_results<sm_type>& results_,
+        value_stack<value_type>& values_, functor& action_)
+    {
+        // Qualify token to prevent arg dependant lookup
+        typedef parsertl::token<lexer_iterator> token;
+        const value_reduction<sm_type, value_type>
+            reduction_(sm_, results_, values_);
+
+        values_.clear();
+
+        while (results_.entry.action != error)
+        {
+            switch (results_.entry.action)
+            {
+            case shift:
+                results_.stack.push_back(results_.entry.param);
+                action_(token(iter_->id, iter_->first, iter_->second),
+                    values_.push());
+
+                if (iter_->id != 0)
+                    ++iter_;
+
+                results_.token_id = iter_->id;
+
+                if (results_.token_id == lexer_iterator::value_type::npos())
+                {
+                    results_.entry.action = error;
+                    results_.entry.param = unknown_token;
+                }
+                else if (!sm_.default_reduction(results_.stack.back(),
+                    results_.entry))
+                {
+                    results_.entry =
+                        sm_.at(results_.stack.back(), results_.token_id);
+                }
+
+                break;
+            case reduce:
+            {
+                const std::size_t size_ = sm_.rule_size(results_.entry.param);
+
+                values_.push();
+                action_(reduction_);
+
+                if (size_)
+                {
+                    using std::swap;
+
+                    results_.stack.resize(results_.stack.size() - size_);
+                    swap(values_[values_.size() - 1 - size_], values_.top());
+                    values_.pop(size_);
+                }
+
+                results_.token_id = sm_.rule_lhs(results_.entry.param);
+                results_.entry =
+                    sm_.at(results_.stack.back(), results_.token_id);
+
+                // Take the goto now rather than on the next iteration.
+                if (results_.entry.action == go_to)
+                {
+                    results_.stack.push_back(results_.entry.param);
+                    results_.token_id = iter_->id;
+
+                    if (!sm_.default_reduction(results_.stack.back(),
+                        results_.entry))
+                    {
+                        results_.entry =
+                            sm_.at(results_.stack.back(), results_.token_id);
+                    }
+                }
+
+                break;
+            }
+            case go_to:
+                results_.stack.push_back(results_.entry.param);
+                results_.token_id = iter_->id;
+
+                if (!sm_.default_reduction(results_.stack.back(),
+                    results_.entry))
+                {
+                    results_.entry =
+                        sm_.at(results_.stack.back(), results_.token_id);
+                }
+
+                break;
+            default:
+                // accept
+                // error
+                break;
+            }
+
+            if (results_.entry.action == accept)
+            {
+                const std::size_t size_ = sm_.rule_size(results_.entry.param);
+
+                if (size_)
+                {
+                    results_.stack.resize(results_.stack.size() - size_);
+                }
+
+                // Drop the end of input value.
+                if (values_.size() > 1)
+                {
+                    values_.pop(values_.size() - 1);
+                }
+
+                break;
+            }
+        }
+
+        return results_.entry.action == accept;
+    }
+}
+
+#endif
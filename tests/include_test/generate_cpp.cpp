@@ -0,0 +1,2 @@
+#include "../../include/parsertl/generate_cpp.hpp"
+
@@ -0,0 +1,2 @@
+#include "../../include/parsertl/generate_tables.hpp"
+
@@ -0,0 +1,2 @@
+#include "../../include/parsertl/parse_tree.hpp"
+
@@ -0,0 +1,2 @@
+#include "../../include/parsertl/static_state_machine.hpp"
+